@@ -6,24 +6,35 @@
 #include <sys/wait.h>
 #include <semaphore.h>
 #include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <stdarg.h>
+#include <errno.h>
+#include <limits.h>
+#include <ctype.h>
 #include <algorithm> // For std::max
 #include <vector>
 #include <iostream>
 #include <map>
-#define MAX_RESOURCE_TYPES 10
-#define MAX_INSTANCES 50
+#include <string>
+#include <cmath>
+#include <chrono>
 #define MAX_PROCESSES 10
-#define MAX_INSTANCE_NAME_LENGTH 100
-#define MAX_INSTRUCTIONS 100
-#define MAX_STRING_LENGTH 100
-#define MAX_LINE_LENGTH 256
+#define ARENA_BLOCK_SIZE (1 << 20) // Parse arena grows in blocks of this many bytes
+#define DETECTION_INTERVAL 1 // Run the deadlock detector after this many blocked requests
+#define BENCHMARK_ITERATIONS 2000 // Repetitions of the interleaved run per benchmark configuration
+#define MAX_BENCHMARK_STEPS 10000 // Guard against processes that can never finish (e.g. starved requests)
+#define SPARSE_DENSITY_THRESHOLD 0.25 // Switch to the sparse layout below this fraction of non-zero max demand entries
 
+#define LOG(...) do { if (verbose) printf(__VA_ARGS__); } while (0)
 
 typedef enum { EDF, LLF } SchedulerType;
+typedef enum { AVOIDANCE, DETECTION } DeadlockMode; // Banker's avoidance or detection-and-recovery
+typedef enum { DENSE, SPARSE } MatrixLayout;
 
 typedef struct {
-    char type[MAX_STRING_LENGTH]; // Resource type
-    char instances[MAX_INSTANCES][MAX_STRING_LENGTH]; // Instances names
+    char* type; // Resource type
+    char** instances; // Instances names
     int instance_count;
 } ResourceType;
 
@@ -31,10 +42,13 @@ typedef struct {
     int original_deadline;
     int deadline; // Adjusted for relative deadline tracking
     int computation_time;
-    char instructions[MAX_INSTRUCTIONS][MAX_STRING_LENGTH];
+    char** instructions; // Arena allocated, one string per instruction
     int instruction_count;
-    char masterString[MAX_STRING_LENGTH * MAX_INSTANCES]; // Adjusted size
+    std::string masterString; // Grows with the instance names appended to it
     int deadline_misses; // Tracks how many times the process missed its deadline
+    int original_computation_time;
+    int next_instruction; // Index of the next instruction for the interleaved benchmark run
+    int rollbacks; // Times this process was chosen as a deadlock recovery victim
 } Process;
 
 typedef struct {
@@ -44,110 +58,455 @@ typedef struct {
     int laxity; // For LLF scheduling
 } ProcessState;
 
+typedef struct {
+    long requestsGranted;
+    long requestsBlocked; // Requests that had to wait (unsafe in avoidance, unavailable in detection)
+    long safetyChecks; // Full Banker's safety checks performed
+    long detectorRuns;
+    long deadlocksFound;
+    long rollbacks;
+    long instructionsExecuted;
+} DeadlockStats;
+
+typedef struct {
+    double utilization; // Sum of computation/deadline over all processes
+    int demandFeasible; // Processor-demand (EDF) test result
+    int firstDemandMiss; // Process whose deadline the cumulative demand first exceeds, -1 if none
+    int demandAtMiss;
+    int laxityFeasible; // Every process has non-negative laxity
+    int minLaxity;
+    int minLaxityProcess;
+} SchedulabilityReport;
+
+// Max demand, allocation, need and pending requests, stored row by row with one entry per
+// (process, resource type) pair. The dense layout keeps an entry for every resource type
+// (entry = rowStart[i] + resource). The sparse (CSR) layout only keeps the resource types a
+// process declared a non-zero max demand for, listed in ascending order in resource[]. A process
+// is never granted more than its max demand, so allocation, need and pending requests always
+// fit in the same pattern and the Banker's loops only walk a process's own entries.
+typedef struct {
+    MatrixLayout layout;
+    std::vector<int> rowStart; // Entries of process i are [rowStart[i], rowStart[i + 1])
+    std::vector<int> resource; // Resource type of each entry (sparse layout only)
+    std::vector<int> maxDemand;
+    std::vector<int> allocation;
+    std::vector<int> need;
+    std::vector<int> pendingRequest; // Outstanding blocked request per process (detection mode)
+} DemandMatrix;
+
+typedef struct {
+    int resource;
+    int amount;
+} ResourceAmount;
+
+typedef std::vector<ResourceAmount> ResourceVector; // Non-zero entries of a request or release vector
+
+typedef struct {
+    std::vector<char*> blocks;
+    char* current;
+    size_t remaining;
+} Arena;
+
+// Cursor over a memory mapped input file
+typedef struct {
+    const char* base;
+    const char* cursor;
+    const char* end;
+    const char* filename;
+    int line; // Current line, for error messages
+    size_t size;
+    int pendingNewline; // The last line returned by scanLine ended in a newline not yet counted
+} Scanner;
+
 ProcessState processStates[MAX_PROCESSES];
 SchedulerType currentScheduler = EDF;
-int available[MAX_RESOURCE_TYPES];
-int allocation[MAX_PROCESSES][MAX_RESOURCE_TYPES];
-int maxDemand[MAX_PROCESSES][MAX_RESOURCE_TYPES];
+DeadlockMode currentDeadlockMode = AVOIDANCE;
+DeadlockStats stats;
+int verbose = 1; // Per-instruction output; disabled while benchmarking
+std::vector<int> available;
+std::vector<int> initialAvailable; // Snapshot of available after parsing, used to reset between runs
+int blockedSinceDetection = 0;
+DemandMatrix demand;
 Process processes[MAX_PROCESSES];
-ResourceType resourceTypes[MAX_RESOURCE_TYPES];
+std::vector<ResourceType> resourceTypes;
+Arena parseArena;
+size_t bytesParsed = 0;
 int resourceTypeCount = 0, resourceCount, processCount;
-int need[MAX_PROCESSES][MAX_RESOURCE_TYPES];
 sem_t resourceAccess;
 sem_t scheduleAccess;
 void executeProcessInstructions(int processIndex);
+
+// Resource type stored in an entry of a process's row
+inline int entryResource(int processIndex, int entry) {
+    return demand.layout == DENSE ? entry - demand.rowStart[processIndex] : demand.resource[entry];
+}
+
+// Entry of (process, resource type), or -1 when the sparse layout has none because the max demand is 0
+int findEntry(int processIndex, int resourceIndex) {
+    if (resourceIndex < 0 || resourceIndex >= resourceCount) return -1;
+    if (demand.layout == DENSE) return demand.rowStart[processIndex] + resourceIndex;
+
+    auto begin = demand.resource.begin() + demand.rowStart[processIndex];
+    auto end = demand.resource.begin() + demand.rowStart[processIndex + 1];
+    auto it = std::lower_bound(begin, end, resourceIndex);
+    return (it != end && *it == resourceIndex) ? (int)(it - demand.resource.begin()) : -1;
+}
+
+int allocationOf(int processIndex, int resourceIndex) {
+    int entry = findEntry(processIndex, resourceIndex);
+    return entry < 0 ? 0 : demand.allocation[entry];
+}
+
+// Builds the demand matrix from the non-zero max demand entries of every process,
+// choosing the layout from the density of the matrix
+void buildDemandMatrix(const std::vector<ResourceVector>& maxRows) {
+    long nonZero = 0;
+    for (const auto& row : maxRows) nonZero += row.size();
+    double density = processCount * resourceCount > 0 ? (double)nonZero / ((double)processCount * resourceCount) : 1.0;
+    demand.layout = density < SPARSE_DENSITY_THRESHOLD ? SPARSE : DENSE;
+
+    demand.rowStart.assign(processCount + 1, 0);
+    demand.resource.clear();
+    demand.maxDemand.clear();
+    for (int i = 0; i < processCount; i++) {
+        demand.rowStart[i] = demand.maxDemand.size();
+        if (demand.layout == DENSE) {
+            demand.maxDemand.resize(demand.maxDemand.size() + resourceCount, 0);
+            for (const auto& value : maxRows[i])
+                demand.maxDemand[demand.rowStart[i] + value.resource] = value.amount;
+        } else {
+            for (const auto& value : maxRows[i]) {
+                demand.resource.push_back(value.resource);
+                demand.maxDemand.push_back(value.amount);
+            }
+        }
+    }
+    demand.rowStart[processCount] = demand.maxDemand.size();
+    demand.allocation.assign(demand.maxDemand.size(), 0);
+    demand.need = demand.maxDemand; // Initially, allocation is zero
+    demand.pendingRequest.assign(demand.maxDemand.size(), 0);
+
+    LOG("Using %s demand matrix (%ld of %ld entries non-zero, density %.3f)\n",
+           demand.layout == DENSE ? "dense" : "sparse", nonZero, (long)processCount * resourceCount, density);
+}
+
+// Parses a parenthesized vector such as "request(0, 2, 0, 1)" into its non-zero entries
+void parseResourceVector(const char* instruction, ResourceVector& values) {
+    values.clear();
+    const char* cursor = strchr(instruction, '(');
+    if (cursor == NULL) return;
+    cursor++;
+    for (int resourceIndex = 0; resourceIndex < resourceCount; resourceIndex++) {
+        char* end;
+        long amount = strtol(cursor, &end, 10);
+        if (end == cursor) break; // No more numbers
+        if (amount != 0) values.push_back({resourceIndex, (int)amount});
+        cursor = end;
+        while (*cursor == ' ' || *cursor == ',') cursor++;
+    }
+}
+
 // Function Prototypes
-void parseOperationFile(const char* filename) {
-    FILE* file = fopen(filename, "r");
-    if (!file) {
-        perror("Failed to open operation file");
+// Bump allocator for everything the parsers build (instruction text, resource names and the
+// pointer tables that index them). Nothing is freed individually; it all lives until exit.
+void* arenaAlloc(size_t size) {
+    size = (size + 7) & ~(size_t)7;
+    if (size > parseArena.remaining) {
+        size_t blockSize = std::max((size_t)ARENA_BLOCK_SIZE, size);
+        parseArena.current = (char*)malloc(blockSize);
+        if (!parseArena.current) {
+            perror("Failed to allocate parse arena");
+            exit(EXIT_FAILURE);
+        }
+        parseArena.blocks.push_back(parseArena.current);
+        parseArena.remaining = blockSize;
+    }
+    void* memory = parseArena.current;
+    parseArena.current += size;
+    parseArena.remaining -= size;
+    return memory;
+}
+
+char* arenaString(const char* start, const char* stop) {
+    char* copy = (char*)arenaAlloc(stop - start + 1);
+    memcpy(copy, start, stop - start);
+    copy[stop - start] = '\0';
+    return copy;
+}
+
+// Maps a whole input file read-only and sets up a scanner over it
+Scanner openScanner(const char* filename, const char* description) {
+    Scanner scanner = {NULL, NULL, NULL, filename, 1, 0, 0};
+    int fd = open(filename, O_RDONLY);
+    if (fd < 0) {
+        fprintf(stderr, "Failed to open %s: %s: %s\n", description, filename, strerror(errno));
         exit(EXIT_FAILURE);
     }
+    struct stat info;
+    if (fstat(fd, &info) < 0) {
+        perror("Failed to stat input file");
+        exit(EXIT_FAILURE);
+    }
+    scanner.size = info.st_size;
+    if (scanner.size > 0) {
+        void* mapping = mmap(NULL, scanner.size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (mapping == MAP_FAILED) {
+            perror("Failed to map input file");
+            exit(EXIT_FAILURE);
+        }
+        madvise(mapping, scanner.size, MADV_SEQUENTIAL);
+        scanner.base = (const char*)mapping;
+    }
+    close(fd);
+    scanner.cursor = scanner.base;
+    scanner.end = scanner.base + scanner.size;
+    return scanner;
+}
+
+void closeScanner(Scanner* scanner) {
+    if (scanner->base) munmap((void*)scanner->base, scanner->size);
+    bytesParsed += scanner->size;
+    scanner->base = scanner->cursor = scanner->end = NULL;
+}
+
+// Reports a malformed input with its location and stops
+void parseError(const Scanner* scanner, const char* format, ...) {
+    va_list args;
+    va_start(args, format);
+    fprintf(stderr, "%s:%d: ", scanner->filename, scanner->line);
+    vfprintf(stderr, format, args);
+    fprintf(stderr, "\n");
+    va_end(args);
+    exit(EXIT_FAILURE);
+}
+
+// Skips whitespace, commas and /* */ comments between numbers, counting lines
+void skipSeparators(Scanner* scanner) {
+    while (scanner->cursor < scanner->end) {
+        char c = *scanner->cursor;
+        if (c == '\n') {
+            scanner->line++;
+        } else if (c == '/' && scanner->cursor + 1 < scanner->end && scanner->cursor[1] == '*') {
+            const char* close = (const char*)memmem(scanner->cursor + 2, scanner->end - scanner->cursor - 2, "*/", 2);
+            const char* stop = close ? close + 2 : scanner->end;
+            scanner->line += std::count(scanner->cursor, stop, '\n');
+            scanner->cursor = stop;
+            continue;
+        } else if (c != ' ' && c != '\t' && c != '\r' && c != ',') {
+            return;
+        }
+        scanner->cursor++;
+    }
+}
 
-    char line[MAX_LINE_LENGTH];
-    fscanf(file, "%d %d", &resourceCount, &processCount);
+int scanInt(Scanner* scanner, const char* what) {
+    skipSeparators(scanner);
+    const char* p = scanner->cursor;
+    int negative = p < scanner->end && *p == '-';
+    if (negative) p++;
+    if (p >= scanner->end || *p < '0' || *p > '9') {
+        parseError(scanner, "expected an integer for %s", what);
+    }
+    long value = 0;
+    while (p < scanner->end && *p >= '0' && *p <= '9') {
+        value = value * 10 + (*p - '0');
+        if (value > INT_MAX) parseError(scanner, "integer for %s is out of range", what);
+        p++;
+    }
+    scanner->cursor = p;
+    return negative ? -(int)value : (int)value;
+}
+
+// Returns the next line with surrounding whitespace, a trailing ';' and /* */ comments removed.
+// Returns 0 at the end of the file.
+int scanLine(Scanner* scanner, const char** start, const char** stop) {
+    if (scanner->pendingNewline) scanner->line++; // Errors refer to the line returned last
+    scanner->pendingNewline = 0;
+    if (scanner->cursor >= scanner->end) return 0;
+    const char* lineEnd = (const char*)memchr(scanner->cursor, '\n', scanner->end - scanner->cursor);
+    if (!lineEnd) lineEnd = scanner->end;
+
+    const char* s = scanner->cursor;
+    const char* e = lineEnd;
+    const char* comment = (const char*)memmem(s, e - s, "/*", 2);
+    if (comment) e = comment;
+    while (s < e && (*s == ' ' || *s == '\t')) s++;
+    while (e > s && (e[-1] == ' ' || e[-1] == '\t' || e[-1] == '\r' || e[-1] == ';')) e--;
+
+    scanner->pendingNewline = lineEnd < scanner->end;
+    scanner->cursor = lineEnd < scanner->end ? lineEnd + 1 : lineEnd;
+    *start = s;
+    *stop = e;
+    return 1;
+}
+
+// Parses integers from the rest of a line into values, returns how many were found
+int scanLineInts(Scanner* scanner, const char* s, const char* e, int values[], int maxValues) {
+    int found = 0;
+    while (found < maxValues) {
+        while (s < e && (*s == ' ' || *s == '\t' || *s == ',')) s++;
+        if (s >= e) break;
+        // Digits are read by hand: the mapping is not NUL terminated, so strtol could run past it
+        const char* p = s;
+        int negative = *p == '-';
+        if (negative) p++;
+        if (p >= e || *p < '0' || *p > '9') {
+            parseError(scanner, "expected an integer, found '%.*s'", (int)(e - s), s);
+        }
+        long value = 0;
+        while (p < e && *p >= '0' && *p <= '9') {
+            value = value * 10 + (*p - '0');
+            if (value > INT_MAX) parseError(scanner, "integer '%.*s' is out of range", (int)(e - s), s);
+            p++;
+        }
+        values[found++] = negative ? -(int)value : (int)value;
+        s = p;
+    }
+    return found;
+}
+
+// A process block closes with "end" or "end." as the whole line
+int isEndLine(const char* start, const char* stop) {
+    if (stop > start && stop[-1] == '.') stop--;
+    return stop - start == 3 && strncmp(start, "end", 3) == 0;
+}
+
+// Moves the instruction pointers collected for a process into the arena
+void finishProcess(Process* proc, std::vector<char*>& pendingInstructions) {
+    proc->instruction_count = pendingInstructions.size();
+    proc->instructions = (char**)arenaAlloc(sizeof(char*) * std::max((size_t)1, pendingInstructions.size()));
+    std::copy(pendingInstructions.begin(), pendingInstructions.end(), proc->instructions);
+    pendingInstructions.clear();
+}
+
+// Single pass over the mapped operation file: the header numbers, then one process block at a time.
+// A process header is "process_<k>:" followed by its deadline and computation time, either on the
+// same line or on the lines after it. Instructions are one per line; "end." closes the process.
+void parseOperationFile(const char* filename) {
+    Scanner scanner = openScanner(filename, "operation file");
+
+    resourceCount = scanInt(&scanner, "the number of resources");
+    processCount = scanInt(&scanner, "the number of processes");
+    if (resourceCount <= 0) parseError(&scanner, "the number of resources must be positive");
+    if (processCount <= 0 || processCount > MAX_PROCESSES) {
+        parseError(&scanner, "the number of processes must be between 1 and %d", MAX_PROCESSES);
+    }
 
     // Read available resources
+    available.assign(resourceCount, 0);
     for (int i = 0; i < resourceCount; i++) {
-        fscanf(file, "%d", &available[i]);
+        available[i] = scanInt(&scanner, "available");
     }
 
-    // Read max demand for each process
+    // Read max demand for each process, keeping only the non-zero entries until the layout is chosen
+    std::vector<ResourceVector> maxRows(processCount);
     for (int i = 0; i < processCount; i++) {
         for (int j = 0; j < resourceCount; j++) {
-            fscanf(file, "%d", &maxDemand[i][j]);
+            int value = scanInt(&scanner, "max demand");
+            if (value != 0) maxRows[i].push_back({j, value});
         }
     }
 
-    // Skip to the next line
-    fgets(line, MAX_LINE_LENGTH, file);
+    // The rest of the file is line oriented; drop what is left of the last matrix line
+    const char* start;
+    const char* stop;
+    scanLine(&scanner, &start, &stop);
 
+    std::vector<char*> pendingInstructions;
     int currentProcess = -1;
-    while (fgets(line, MAX_LINE_LENGTH, file)) {
-        // Remove newline character
-        line[strcspn(line, "\n")] = 0;
+    int headerValues[2];
+    int headerValuesRead = 2;
+    while (scanLine(&scanner, &start, &stop)) {
+        if (start == stop) continue;
 
         // Check for process identifier
-        if (strncmp(line, "process_", 8) == 0) {
-            currentProcess++;
-            sscanf(line, "process_%*d: %d %d", &processes[currentProcess].deadline, &processes[currentProcess].computation_time);
-            processes[currentProcess].instruction_count = 0;
-            processes[currentProcess].masterString[0] = '\0';
-        } else if (currentProcess != -1) {
-            // Assuming instructions don't span multiple lines
-            strcpy(processes[currentProcess].instructions[processes[currentProcess].instruction_count], line);
-            processes[currentProcess].instruction_count++;
+        if (stop - start >= 8 && strncmp(start, "process_", 8) == 0) {
+            if (headerValuesRead < 2) parseError(&scanner, "process_%d is missing its deadline or computation time", currentProcess + 1);
+            if (currentProcess >= 0) finishProcess(&processes[currentProcess], pendingInstructions);
+            if (++currentProcess >= processCount) {
+                parseError(&scanner, "more process blocks than the %d processes declared", processCount);
+            }
+            const char* colon = (const char*)memchr(start, ':', stop - start);
+            if (!colon) parseError(&scanner, "expected ':' after process name");
+            headerValuesRead = scanLineInts(&scanner, colon + 1, stop, headerValues, 2);
+        } else if (currentProcess == -1) {
+            parseError(&scanner, "instruction '%.*s' before the first process", (int)(stop - start), start);
+        } else if (headerValuesRead < 2) {
+            // Deadline and computation time on their own lines
+            headerValuesRead += scanLineInts(&scanner, start, stop, headerValues + headerValuesRead, 2 - headerValuesRead);
+        } else if (isEndLine(start, stop)) {
+            continue; // end takes no time; leftover resources are released when the process finishes
+        } else {
+            pendingInstructions.push_back(arenaString(start, stop));
+            continue;
         }
-    }
 
-    // Initialize the need matrix here, outside and after the while loop
-    for (int i = 0; i < processCount; i++) {
-        for (int j = 0; j < resourceCount; j++) {
-            need[i][j] = maxDemand[i][j] - allocation[i][j]; // Initially, allocation is zero
+        if (headerValuesRead == 2) {
+            Process* proc = &processes[currentProcess];
+            proc->deadline = headerValues[0];
+            proc->computation_time = headerValues[1];
+            proc->original_deadline = proc->deadline;
+            proc->original_computation_time = proc->computation_time;
+            proc->masterString.clear();
         }
     }
+    if (currentProcess + 1 != processCount || headerValuesRead < 2) {
+        parseError(&scanner, "expected %d complete process blocks, found %d", processCount, currentProcess + 1);
+    }
+    finishProcess(&processes[currentProcess], pendingInstructions);
+
+    // Initialize the need matrix here, outside and after the while loop
+    buildDemandMatrix(maxRows);
+    initialAvailable = available;
 
-    fclose(file);
+    closeScanner(&scanner);
 }
 
+// Each line of the word file is "type: instance, instance, ..." with an optional "R<k>:" label in front
 void parseWordFile(const char* filename) {
-    FILE* file = fopen(filename, "r");
-    if (!file) {
-        perror("Failed to open word file");
-        exit(EXIT_FAILURE);
-    }
-
-    char line[256];
-    while (fgets(line, sizeof(line), file)) {
-        // Remove newline character
-        line[strcspn(line, "\n")] = 0;
+    Scanner scanner = openScanner(filename, "word file");
+    const char* start;
+    const char* stop;
+    std::vector<char*> instances;
+
+    while (scanLine(&scanner, &start, &stop)) {
+        if (start == stop) continue;
+
+        const char* colon = (const char*)memchr(start, ':', stop - start);
+        if (!colon) parseError(&scanner, "expected 'type: instance, ...'");
+        const char* second = (const char*)memchr(colon + 1, ':', stop - colon - 1);
+        if (second && *start == 'R' && std::all_of(start + 1, colon, [](char c) { return isdigit((unsigned char)c) != 0; })) {
+            // Skip the "R<k>:" label
+            start = colon + 1;
+            colon = second;
+            while (start < colon && *start == ' ') start++;
+        }
 
-        char* token = strtok(line, ":"); // Split line at the first ":"
-        if (token != NULL) {
-            strncpy(resourceTypes[resourceTypeCount].type, token, MAX_INSTANCE_NAME_LENGTH);
-            token = strtok(NULL, ""); // This time, get the rest of the line after ":"
-            if (token != NULL && token[0] == ' ') {
-                // Skip leading spaces, if any, after ":"
-                token++;
-            }
-            if (token != NULL) {
-                // Now split the remaining part by ","
-                char* instance = strtok(token, ",");
-                int instanceIndex = 0;
-                while (instance != NULL) {
-                    // Trim leading spaces from each instance, if necessary
-                    while(*instance == ' ') instance++;
-                    strncpy(resourceTypes[resourceTypeCount].instances[instanceIndex], instance, MAX_INSTANCE_NAME_LENGTH);
-                    instanceIndex++;
-                    instance = strtok(NULL, ",");
-                }
-                resourceTypes[resourceTypeCount].instance_count = instanceIndex;
-            }
-            resourceTypeCount++;
+        ResourceType type;
+        const char* typeEnd = colon;
+        while (typeEnd > start && typeEnd[-1] == ' ') typeEnd--;
+        type.type = arenaString(start, typeEnd);
+
+        // Now split the remaining part by ","
+        instances.clear();
+        const char* instance = colon + 1;
+        while (instance < stop) {
+            const char* comma = (const char*)memchr(instance, ',', stop - instance);
+            const char* instanceEnd = comma ? comma : stop;
+            while (instance < instanceEnd && *instance == ' ') instance++;
+            const char* trimmed = instanceEnd;
+            while (trimmed > instance && trimmed[-1] == ' ') trimmed--;
+            if (trimmed > instance) instances.push_back(arenaString(instance, trimmed));
+            instance = comma ? comma + 1 : stop;
         }
+        type.instance_count = instances.size();
+        type.instances = (char**)arenaAlloc(sizeof(char*) * std::max((size_t)1, instances.size()));
+        std::copy(instances.begin(), instances.end(), type.instances);
+        resourceTypes.push_back(type);
     }
+    resourceTypeCount = resourceTypes.size();
 
-    fclose(file);
+    closeScanner(&scanner);
 }
 
 void updateProcessStates() {
@@ -177,6 +536,82 @@ int compareLLFSJF(const void* a, const void* b) {
     return p1->remainingTime - p2->remainingTime; // Shorter jobs first for tie
 }
 
+// Time the simulation charges for a process: calculate(n) takes n units, every other instruction 1
+int instructionDemand(const Process* proc) {
+    int totalTime = 0;
+    for (int i = 0; i < proc->instruction_count; i++) {
+        int execTime = 1;
+        if (strncmp(proc->instructions[i], "calculate", 9) == 0) {
+            sscanf(proc->instructions[i], "calculate(%d)", &execTime);
+        }
+        totalTime += execTime;
+    }
+    return totalTime;
+}
+
+// Schedulability analysis run on the parsed task set before any simulation.
+// All processes are released at time 0 with relative deadlines, so:
+//  - utilization (density) sum(C/D) <= 1 is sufficient for EDF,
+//  - the processor-demand test (demand of every job with deadline <= d must fit in d) is exact for EDF,
+//  - a process with negative laxity D - C misses its deadline even when running alone.
+SchedulabilityReport analyzeSchedulability() {
+    SchedulabilityReport report;
+    ProcessState byDeadline[MAX_PROCESSES];
+    memset(&report, 0, sizeof(report));
+    report.demandFeasible = 1;
+    report.laxityFeasible = 1;
+    report.firstDemandMiss = -1;
+    report.minLaxityProcess = -1;
+
+    for (int i = 0; i < processCount; i++) {
+        int processDemand = std::max(processes[i].computation_time, instructionDemand(&processes[i]));
+        int deadline = processes[i].deadline;
+        byDeadline[i].pid = i;
+        byDeadline[i].deadline = deadline;
+        byDeadline[i].remainingTime = processDemand;
+        byDeadline[i].laxity = deadline - processDemand;
+
+        report.utilization += deadline > 0 ? (double)processDemand / deadline : (processDemand > 0 ? INFINITY : 0.0);
+        if (report.minLaxityProcess == -1 || byDeadline[i].laxity < report.minLaxity) {
+            report.minLaxity = byDeadline[i].laxity;
+            report.minLaxityProcess = i;
+        }
+    }
+    report.laxityFeasible = report.minLaxityProcess == -1 || report.minLaxity >= 0;
+
+    // Processor demand: walk the deadlines in order accumulating the work that has to be done by each
+    qsort(byDeadline, processCount, sizeof(ProcessState), compareEDFLJF);
+    int cumulativeDemand = 0;
+    for (int i = 0; i < processCount; i++) {
+        cumulativeDemand += byDeadline[i].remainingTime;
+        if (cumulativeDemand > byDeadline[i].deadline) {
+            report.demandFeasible = 0;
+            report.firstDemandMiss = byDeadline[i].pid;
+            report.demandAtMiss = cumulativeDemand;
+            break;
+        }
+    }
+    return report;
+}
+
+void printSchedulabilityReport(const SchedulabilityReport* report) {
+    printf("Schedulability pre-check:\n");
+    printf("  Total utilization: %.3f%s\n", report->utilization,
+           report->utilization <= 1.0 ? " (EDF feasible by utilization bound)" : "");
+    if (report->demandFeasible) {
+        printf("  Processor demand test (EDF): passed\n");
+    } else {
+        printf("  Processor demand test (EDF): FAILED, demand %d exceeds deadline %d of process %d\n",
+               report->demandAtMiss, processes[report->firstDemandMiss].deadline, report->firstDemandMiss + 1);
+    }
+    if (report->laxityFeasible) {
+        printf("  Laxity test: passed\n");
+    } else {
+        printf("  Laxity test: FAILED, process %d has laxity %d\n", report->minLaxityProcess + 1, report->minLaxity);
+    }
+    printf("  Task set is %s\n", report->demandFeasible && report->laxityFeasible ? "feasible" : "INFEASIBLE");
+}
+
 // Function to decide the next process based on currentScheduler
 int getNextProcess() {
     if (currentScheduler == 0) { // EDF
@@ -205,26 +640,27 @@ int findResourceTypeIndex(const char* resourceName) {
 void updateMasterString(int processIndex, int resourceIndex, int amountUsed) {
     Process* proc = &processes[processIndex];
 
-    if (strlen(proc->masterString) > 0) strcat(proc->masterString, ", ");
+    if (!proc->masterString.empty()) proc->masterString += ", ";
 
     // Assuming each `use_resources` consumes the first instance(s) available for simplicity
     for (int i = 0; i < amountUsed && i < resourceTypes[resourceIndex].instance_count; i++) {
-        strcat(proc->masterString, resourceTypes[resourceIndex].instances[i]);
-        if (i < amountUsed - 1) strcat(proc->masterString, ", ");
+        proc->masterString += resourceTypes[resourceIndex].instances[i];
+        if (i < amountUsed - 1) proc->masterString += ", ";
     }
 }
 
 void updateMasterStringAfterRelease(int processIndex) {
     Process* proc = &processes[processIndex];
-    strcpy(proc->masterString, ""); // Reset the master string
+    proc->masterString.clear(); // Reset the master string
 
     for (int j = 0; j < resourceTypeCount; j++) {
-        if (allocation[processIndex][j] > 0) {
-            if (strlen(proc->masterString) > 0) strcat(proc->masterString, ", ");
-            strcat(proc->masterString, resourceTypes[j].type);
-            for (int k = 0; k < allocation[processIndex][j] && k < resourceTypes[j].instance_count; k++) {
-                strcat(proc->masterString, ": ");
-                strcat(proc->masterString, resourceTypes[j].instances[k]);
+        int allocated = allocationOf(processIndex, j);
+        if (allocated > 0) {
+            if (!proc->masterString.empty()) proc->masterString += ", ";
+            proc->masterString += resourceTypes[j].type;
+            for (int k = 0; k < allocated && k < resourceTypes[j].instance_count; k++) {
+                proc->masterString += ": ";
+                proc->masterString += resourceTypes[j].instances[k];
             }
         }
     }
@@ -233,56 +669,63 @@ void updateMasterStringBasedOnAllocation(Process* proc) {
     // Clears and rebuilds the master string based on current allocations
     std::map<std::string, std::vector<std::string>> allocations;
     for (int i = 0; i < resourceTypeCount; i++) {
-        for (int j = 0; j < allocation[proc - processes][i]; j++) {
+        int allocated = allocationOf(proc - processes, i);
+        for (int j = 0; j < allocated && j < resourceTypes[i].instance_count; j++) {
             allocations[resourceTypes[i].type].push_back(resourceTypes[i].instances[j]);
         }
     }
 
-    strcpy(proc->masterString, "");
+    proc->masterString.clear();
     for (auto &alloc : allocations) {
-        if (proc->masterString[0]) {
-            strcat(proc->masterString, ", ");
+        if (!proc->masterString.empty()) {
+            proc->masterString += ", ";
         }
-        strcat(proc->masterString, alloc.first.c_str());
-        strcat(proc->masterString, ": ");
+        proc->masterString += alloc.first;
+        proc->masterString += ": ";
         for (size_t i = 0; i < alloc.second.size(); i++) {
             if (i > 0) {
-                strcat(proc->masterString, ", ");
+                proc->masterString += ", ";
             }
-            strcat(proc->masterString, alloc.second[i].c_str());
+            proc->masterString += alloc.second[i];
         }
     }
 }
 
-int canFinishWithAvailable(int processIndex, int work[], int finish[]) {
-    for (int i = 0; i < resourceCount; i++) {
-        if (maxDemand[processIndex][i] - allocation[processIndex][i] > work[i]) {
+int canFinishWithAvailable(int processIndex, const int work[], int finish[]) {
+    for (int e = demand.rowStart[processIndex]; e < demand.rowStart[processIndex + 1]; e++) {
+        if (demand.maxDemand[e] - demand.allocation[e] > work[entryResource(processIndex, e)]) {
             return 0;
         }
     }
     return 1;
 }
 
-// The main safety check according to the Banker's Algorithm
+// Gives back (sign 1) or takes away again (sign -1) everything a process holds to available
+void returnAllocationToWork(int processIndex, int sign) {
+    for (int e = demand.rowStart[processIndex]; e < demand.rowStart[processIndex + 1]; e++)
+        available[entryResource(processIndex, e)] += sign * demand.allocation[e];
+}
+
+// The main safety check according to the Banker's Algorithm.
+// available itself is used as the work vector, and whatever finished processes handed back is
+// taken out again at the end, so the check never copies or scans all resource types; it only
+// walks the entries of each process's row.
 
 int isStateSafe() {
-    int work[MAX_RESOURCE_TYPES];
     int finish[MAX_PROCESSES] = {0};
-    memcpy(work, available, sizeof(available));
 
     int found, safe = 1;
     do {
         found = 0;
         for (int i = 0; i < processCount; i++) {
             if (!finish[i]) {
-                int j;
-                for (j = 0; j < resourceCount; j++)
-                    if (need[i][j] > work[j])
+                int e, rowEnd = demand.rowStart[i + 1];
+                for (e = demand.rowStart[i]; e < rowEnd; e++)
+                    if (demand.need[e] > available[entryResource(i, e)])
                         break;
 
-                if (j == resourceCount) { // If all needs of process i are met
-                    for (int k = 0; k < resourceCount; k++)
-                        work[k] += allocation[i][k];
+                if (e == rowEnd) { // If all needs of process i are met
+                    returnAllocationToWork(i, 1);
                     finish[i] = 1;
                     found = 1;
                 }
@@ -290,22 +733,36 @@ int isStateSafe() {
         }
     } while (found);
 
-    for (int i = 0; i < processCount; i++)
-        if (!finish[i])
+    for (int i = 0; i < processCount; i++) {
+        if (finish[i])
+            returnAllocationToWork(i, -1);
+        else
             safe = 0;
+    }
 
     return safe;
 }
 
+// Applies (sign 1) or undoes (sign -1) a request against available, allocation and need
+void applyRequest(int processIndex, const ResourceVector& requestedResources, int sign) {
+    for (const auto& request : requestedResources) {
+        int e = findEntry(processIndex, request.resource);
+        available[request.resource] -= sign * request.amount;
+        demand.allocation[e] += sign * request.amount;
+        demand.need[e] -= sign * request.amount;
+    }
+}
+
 // Adjusted isRequestSafe function to include validation and use the isStateSafe function
-int isRequestSafe(int processIndex, int requestedResources[]) {
+int isRequestSafe(int processIndex, const ResourceVector& requestedResources) {
     sem_wait(&resourceAccess); // Lock the critical section
 
     // Validate request does not exceed the process's current needs
     int isRequestExceeds = 0;
-    for (int i = 0; i < resourceCount; i++) {
-        if (requestedResources[i] > need[processIndex][i] || requestedResources[i] > available[i]) {
-            printf("Process %d: Request exceeds the process's needs or available resources.\n", processIndex + 1);
+    for (const auto& request : requestedResources) {
+        int e = findEntry(processIndex, request.resource);
+        if (e < 0 || request.amount > demand.need[e] || request.amount > available[request.resource]) {
+            LOG("Process %d: Request exceeds the process's needs or available resources.\n", processIndex + 1);
             isRequestExceeds = 1;
             break; // Exit the loop as no need to check further
         }
@@ -317,30 +774,174 @@ int isRequestSafe(int processIndex, int requestedResources[]) {
     }
 
     // Temporarily allocate requested resources for the safety check
-    for (int i = 0; i < resourceCount; i++) {
-        available[i] -= requestedResources[i];
-        allocation[processIndex][i] += requestedResources[i];
-        need[processIndex][i] -= requestedResources[i];
-    }
+    applyRequest(processIndex, requestedResources, 1);
 
     // Perform the safety check using the Banker's Algorithm
+    stats.safetyChecks++;
     if (!isStateSafe()) {
         // Rollback if not safe
-        for (int i = 0; i < resourceCount; i++) {
-            available[i] += requestedResources[i];
-            allocation[processIndex][i] -= requestedResources[i];
-            need[processIndex][i] += requestedResources[i];
-        }
-        printf("Process %d: Request denied. Would lead to unsafe state.\n", processIndex + 1);
+        applyRequest(processIndex, requestedResources, -1);
+        LOG("Process %d: Request denied. Would lead to unsafe state.\n", processIndex + 1);
         sem_post(&resourceAccess); // Unlock the critical section before returning
         return 0; // Indicate the request cannot be granted
     }
 
     // If the code reaches here, it means the request was safe and has been successfully granted
-    printf("Process %d: Request granted.\n", processIndex + 1);
+    LOG("Process %d: Request granted.\n", processIndex + 1);
     sem_post(&resourceAccess); // Unlock the critical section before returning
     return 1; // Indicate the request has been successfully granted
 }
+// Returns 1 if the request asks for more than the process declared in its max demand
+int requestExceedsNeed(int processIndex, const ResourceVector& requestedResources) {
+    for (const auto& request : requestedResources) {
+        int e = findEntry(processIndex, request.resource);
+        if (e < 0 || request.amount > demand.need[e]) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+// Deadlock detection over the allocation and pending request matrices.
+// Marks every process that cannot finish in deadlocked[] and returns how many there are.
+// Like isStateSafe it borrows available as the work vector and restores it afterwards.
+int detectDeadlock(int deadlocked[]) {
+    int finish[MAX_PROCESSES] = {0};
+    int returned[MAX_PROCESSES] = {0}; // Processes whose allocation was added to the work vector
+    stats.detectorRuns++;
+
+    // A process holding nothing cannot be part of a circular wait
+    for (int i = 0; i < processCount; i++) {
+        int holds = 0;
+        for (int e = demand.rowStart[i]; e < demand.rowStart[i + 1]; e++)
+            if (demand.allocation[e] > 0)
+                holds = 1;
+        finish[i] = !holds;
+    }
+
+    int found;
+    do {
+        found = 0;
+        for (int i = 0; i < processCount; i++) {
+            if (!finish[i]) {
+                int e, rowEnd = demand.rowStart[i + 1];
+                for (e = demand.rowStart[i]; e < rowEnd; e++)
+                    if (demand.pendingRequest[e] > available[entryResource(i, e)])
+                        break;
+
+                if (e == rowEnd) { // Its outstanding request can be met, so assume it finishes
+                    returnAllocationToWork(i, 1);
+                    returned[i] = 1;
+                    finish[i] = 1;
+                    found = 1;
+                }
+            }
+        }
+    } while (found);
+
+    int count = 0;
+    for (int i = 0; i < processCount; i++) {
+        if (returned[i])
+            returnAllocationToWork(i, -1);
+        deadlocked[i] = !finish[i];
+        count += deadlocked[i];
+    }
+    return count;
+}
+
+// Picks the deadlocked process with the lowest priority under the current scheduler.
+// EDF: latest deadline, shorter job on a tie (LJF prefers longer). LLF: largest laxity, longer job on a tie.
+int selectVictim(int deadlocked[]) {
+    int victim = -1;
+    for (int i = 0; i < processCount; i++) {
+        if (!deadlocked[i]) continue;
+        if (victim == -1) {
+            victim = i;
+            continue;
+        }
+        Process* p = &processes[i];
+        Process* v = &processes[victim];
+        if (currentScheduler == EDF) {
+            if (p->deadline > v->deadline ||
+                (p->deadline == v->deadline && p->computation_time < v->computation_time))
+                victim = i;
+        } else {
+            int pLaxity = p->deadline - p->computation_time;
+            int vLaxity = v->deadline - v->computation_time;
+            if (pLaxity > vLaxity || (pLaxity == vLaxity && p->computation_time > v->computation_time))
+                victim = i;
+        }
+    }
+    return victim;
+}
+
+// Recovery: preempt everything the victim holds and roll it back to its first instruction
+void rollbackProcess(int processIndex) {
+    for (int e = demand.rowStart[processIndex]; e < demand.rowStart[processIndex + 1]; e++) {
+        available[entryResource(processIndex, e)] += demand.allocation[e];
+        demand.allocation[e] = 0;
+        demand.need[e] = demand.maxDemand[e];
+        demand.pendingRequest[e] = 0;
+    }
+    processes[processIndex].next_instruction = 0;
+    processes[processIndex].computation_time = processes[processIndex].original_computation_time;
+    processes[processIndex].masterString.clear();
+    processes[processIndex].rollbacks++;
+    stats.rollbacks++;
+    LOG("Process %d: Rolled back to recover from deadlock.\n", processIndex + 1);
+}
+
+// Runs the detector and keeps recovering until no deadlocked processes remain
+void detectAndRecover() {
+    int deadlocked[MAX_PROCESSES];
+    while (detectDeadlock(deadlocked) > 0) {
+        stats.deadlocksFound++;
+        rollbackProcess(selectVictim(deadlocked));
+    }
+    blockedSinceDetection = 0;
+}
+
+// Detection mode: grant any request that fits in available, no safety check.
+// A request that does not fit is recorded as pending so the detector can see the wait.
+int isRequestAvailable(int processIndex, const ResourceVector& requestedResources) {
+    sem_wait(&resourceAccess); // Lock the critical section
+
+    for (const auto& request : requestedResources) {
+        if (request.amount > available[request.resource]) {
+            for (const auto& pending : requestedResources)
+                demand.pendingRequest[findEntry(processIndex, pending.resource)] = pending.amount;
+            LOG("Process %d: Request blocked. Not enough resources available.\n", processIndex + 1);
+            if (++blockedSinceDetection >= DETECTION_INTERVAL) {
+                detectAndRecover();
+            }
+            sem_post(&resourceAccess);
+            return 0;
+        }
+    }
+
+    applyRequest(processIndex, requestedResources, 1);
+    for (int e = demand.rowStart[processIndex]; e < demand.rowStart[processIndex + 1]; e++)
+        demand.pendingRequest[e] = 0;
+    LOG("Process %d: Request granted.\n", processIndex + 1);
+    sem_post(&resourceAccess);
+    return 1;
+}
+
+// Services a request with the configured deadlock strategy.
+// Returns 1 if granted, 0 if the process has to wait, -1 if the request is invalid.
+int grantRequest(int processIndex, const ResourceVector& requestedResources) {
+    if (requestExceedsNeed(processIndex, requestedResources)) {
+        LOG("Process %d: Request exceeds the process's declared maximum.\n", processIndex + 1);
+        return -1;
+    }
+
+    int granted = currentDeadlockMode == AVOIDANCE ? isRequestSafe(processIndex, requestedResources)
+                                                   : isRequestAvailable(processIndex, requestedResources);
+    if (granted) stats.requestsGranted++;
+    else stats.requestsBlocked++;
+    return granted;
+}
+
 void scheduleNextProcess() {
     sem_wait(&scheduleAccess); // Lock scheduling control
 
@@ -386,91 +987,220 @@ void scheduleNextProcess() {
     sem_post(&scheduleAccess); // Unlock scheduling control
 }
 
-void executeProcessInstructions(int processIndex) {
+// Executes one instruction of a process. Returns 1 when the instruction completed,
+// 0 when it is a request the process has to wait on and retry.
+int executeInstruction(int processIndex, int instructionIndex) {
     Process *proc = &processes[processIndex];
-    int realTimePassed = 0; // Tracks the real time passed to adjust deadlines accurately.
-
-    for (int i = 0; i < proc->instruction_count; i++) {
-        char *instruction = proc->instructions[i];
-        int execTime = 1;
-        if (strncmp(instruction, "calculate", 9) == 0) {
-            sscanf(instruction, "calculate(%d)", &execTime);
-            proc->computation_time = std::max(0, proc->computation_time - execTime);
-            if (proc->deadline - execTime < 0) {
-                printf("Process %d will miss its deadline due to executing: %s\n", processIndex + 1, instruction);
-                proc->deadline_misses++;
-            }else
-                printf("Process %d will not miss its deadline.", processIndex + 1);
-        }
-        else if (strncmp(instruction, "request", 7) == 0) {
-            int requestedResources[MAX_RESOURCE_TYPES] = {0};
-            sscanf(instruction, "request(%d, %d, %d)", &requestedResources[0], &requestedResources[1], &requestedResources[2]);
-
-            if (isRequestSafe(processIndex, requestedResources)) {
-                // Request is safe; update available and allocation
-                for (int j = 0; j < resourceCount; j++) {
-                    available[j] -= requestedResources[j];
-                    allocation[processIndex][j] += requestedResources[j];
-                }
-                printf("Process %d: Request granted.\n", processIndex + 1);
+    char *instruction = proc->instructions[instructionIndex];
+    int execTime = 1;
+    int completed = 1;
+    stats.instructionsExecuted++;
+
+    if (strncmp(instruction, "calculate", 9) == 0) {
+        sscanf(instruction, "calculate(%d)", &execTime);
+        proc->computation_time = std::max(0, proc->computation_time - execTime);
+        if (proc->deadline - execTime < 0) {
+            LOG("Process %d will miss its deadline due to executing: %s\n", processIndex + 1, instruction);
+            proc->deadline_misses++;
+        }else
+            LOG("Process %d will not miss its deadline.", processIndex + 1);
+    }
+    else if (strncmp(instruction, "request", 7) == 0) {
+        ResourceVector requestedResources;
+        parseResourceVector(instruction, requestedResources);
+
+        // grantRequest updates available, allocation and need itself when the request is granted
+        int granted = grantRequest(processIndex, requestedResources);
+        if (granted > 0) {
+            LOG("Process %d: Request granted.\n", processIndex + 1);
+        } else {
+            LOG("Process %d: Request denied.\n", processIndex + 1);
+            // A request that could be granted later has to be retried; the computation time stays the same
+            completed = granted < 0;
+        }
+        execTime = 1;
+    } else if (strncmp(instruction, "use_resources", 13) == 0) {
+        int resourceTypeIndex, amountUsed;
+        sscanf(instruction, "use_resources(%d,%d)", &resourceTypeIndex, &amountUsed);
+        resourceTypeIndex--; // Adjust index to match your 0-based array indexing
+
+        if(resourceTypeIndex >= 0 && resourceTypeIndex < resourceTypeCount) {
+            // Ensure the process has the resources to use
+            int e = findEntry(processIndex, resourceTypeIndex);
+            if (e >= 0 && amountUsed <= demand.allocation[e]) {
+                // Simulate resource usage by adjusting allocation
+                demand.allocation[e] -= amountUsed;
+                // Update the master string to reflect the current resource state
+                updateMasterStringBasedOnAllocation(proc);
+                LOG("Process %d -- Master string after using resources: %s\n", processIndex + 1, proc->masterString.c_str());
             } else {
-                printf("Process %d: Request denied.\n", processIndex + 1);
+                LOG("Process %d: Attempt to use more resources than allocated.\n", processIndex + 1);
             }
-            execTime = 1;
-        } else if (strncmp(instruction, "use_resources", 13) == 0) {
-            int resourceTypeIndex, amountUsed;
-            sscanf(instruction, "use_resources(%d,%d)", &resourceTypeIndex, &amountUsed);
-            resourceTypeIndex--; // Adjust index to match your 0-based array indexing
-
-            if(resourceTypeIndex >= 0 && resourceTypeIndex < resourceTypeCount) {
-                // Ensure the process has the resources to use
-                if (amountUsed <= allocation[processIndex][resourceTypeIndex]) {
-                    // Simulate resource usage by adjusting allocation
-                    allocation[processIndex][resourceTypeIndex] -= amountUsed;
-                    // Update the master string to reflect the current resource state
-                    updateMasterStringBasedOnAllocation(proc);
-                    printf("Process %d -- Master string after using resources: %s\n", processIndex + 1, proc->masterString);
-                } else {
-                    printf("Process %d: Attempt to use more resources than allocated.\n", processIndex + 1);
-                }
-            } else {
-                printf("Process %d: Resource type index %d out of bounds.\n", processIndex + 1, resourceTypeIndex + 1);
+        } else {
+            LOG("Process %d: Resource type index %d out of bounds.\n", processIndex + 1, resourceTypeIndex + 1);
+        }
+
+    } else if (strncmp(instruction, "release", 7) == 0) {
+        ResourceVector releaseResources;
+        parseResourceVector(instruction, releaseResources);
+
+        for (const auto& release : releaseResources) {
+            int e = findEntry(processIndex, release.resource);
+            if (e >= 0 && release.amount > 0 && release.amount <= demand.allocation[e]) {
+                demand.allocation[e] -= release.amount;
+                available[release.resource] += release.amount;
             }
+        }
+        // Update the master string after release
+        updateMasterStringBasedOnAllocation(proc);
+        LOG("Process %d: Resources released. Master string updated: %s\n", processIndex + 1, proc->masterString.c_str());
+        execTime = 1;
+    } else if (strcmp(instruction, "print_resources_used") == 0) {
+        LOG("Process %d master string: %s\n", processIndex + 1, proc->masterString.c_str());
+        execTime = 1;
+    }
+    if (completed && strcmp(instruction, "print_resources_used") != 0) {
+        proc->computation_time = std::max(0, proc->computation_time - execTime);
+    }
 
-        } else if (strncmp(instruction, "release", 7) == 0) {
-            int releaseResources[MAX_RESOURCE_TYPES] = {0};
-            sscanf(instruction, "release(%d, %d, %d)",
-                   &releaseResources[0], &releaseResources[1], &releaseResources[2]);
+    // Directly adjust deadline after processing each instruction, simplified without realTimePassed.
+    // A request that has to wait takes no time until it is granted.
+    if (completed) proc->deadline = std::max(0, proc->deadline - execTime);
+    // Check for deadline misses after each instruction.
+    if (proc->deadline_misses > 0) {
+        LOG("Process %d missed its deadline %d times.\n", processIndex + 1, proc->deadline_misses);
+    } else {
+        LOG("Process %d did not miss its deadline.\n", processIndex + 1);
+    }
+    return completed;
+}
 
-            for (int j = 0; j < resourceCount; j++) {
-                if (releaseResources[j] > 0 && releaseResources[j] <= allocation[processIndex][j]) {
-                    allocation[processIndex][j] -= releaseResources[j];
-                    available[j] += releaseResources[j];
-                }
+void executeProcessInstructions(int processIndex) {
+    Process *proc = &processes[processIndex];
+
+    for (int i = 0; i < proc->instruction_count; i++) {
+        executeInstruction(processIndex, i);
+    }
+}
+
+// Restores the parsed state so several runs can be made from one parse
+void resetSimulationState() {
+    available = initialAvailable;
+    std::fill(demand.allocation.begin(), demand.allocation.end(), 0);
+    std::fill(demand.pendingRequest.begin(), demand.pendingRequest.end(), 0);
+    demand.need = demand.maxDemand;
+    for (int i = 0; i < processCount; i++) {
+        processes[i].deadline = processes[i].original_deadline;
+        processes[i].computation_time = processes[i].original_computation_time;
+        processes[i].deadline_misses = 0;
+        processes[i].next_instruction = 0;
+        processes[i].rollbacks = 0;
+        processes[i].masterString.clear();
+    }
+    blockedSinceDetection = 0;
+    memset(&stats, 0, sizeof(stats));
+}
+
+// Releases everything a finished process still holds (the implicit `end`)
+void releaseAllResources(int processIndex) {
+    for (int e = demand.rowStart[processIndex]; e < demand.rowStart[processIndex + 1]; e++) {
+        available[entryResource(processIndex, e)] += demand.allocation[e];
+        demand.allocation[e] = 0;
+        demand.pendingRequest[e] = 0;
+    }
+}
+
+// Interleaves the processes one instruction at a time, always servicing the highest priority
+// unfinished process under currentScheduler. A process whose request has to wait is skipped until
+// available changes; the run stops when every unfinished process is waiting. Returns the number of
+// steps taken.
+int runInterleaved() {
+    int steps = 0;
+    int waiting[MAX_PROCESSES] = {0};
+    while (steps < MAX_BENCHMARK_STEPS) {
+        int next = -1;
+        ProcessState best, candidate;
+        for (int i = 0; i < processCount; i++) {
+            if (processes[i].next_instruction >= processes[i].instruction_count || waiting[i]) continue;
+            candidate.pid = i;
+            candidate.deadline = processes[i].deadline;
+            candidate.remainingTime = processes[i].computation_time;
+            candidate.laxity = candidate.deadline - candidate.remainingTime;
+            if (next == -1 ||
+                (currentScheduler == EDF ? compareEDFLJF(&candidate, &best) : compareLLFSJF(&candidate, &best)) < 0) {
+                best = candidate;
+                next = i;
             }
-            // Update the master string after release
-            updateMasterStringBasedOnAllocation(proc);
-            printf("Process %d: Resources released. Master string updated: %s\n", processIndex + 1, proc->masterString);
-            execTime = 1;
-        } else if (strcmp(instruction, "print_resources_used") == 0) {
-            printf("Process %d master string: %s\n", processIndex + 1, proc->masterString);
-            execTime = 1;
-        }
-        if (strcmp(instruction, "print_resources_used") != 0) {
-            proc->computation_time = std::max(0, proc->computation_time - execTime);
-        }
-
-        // Directly adjust deadline after processing each instruction, simplified without realTimePassed.
-        proc->deadline = std::max(0, proc->deadline - execTime);
-        // Check for deadline misses after each instruction.
-        if (proc->deadline_misses > 0) {
-            printf("Process %d missed its deadline %d times.\n", processIndex + 1, proc->deadline_misses);
+        }
+        if (next == -1) break; // Every process finished or is waiting on a request nothing will release
+
+        Process *proc = &processes[next];
+        std::vector<int> availableBefore = available;
+        // A blocked request is retried once available has changed; a rolled back process has
+        // already been reset to its first instruction by the recovery
+        if (executeInstruction(next, proc->next_instruction)) {
+            proc->next_instruction++;
         } else {
-            printf("Process %d did not miss its deadline.\n", processIndex + 1);
+            waiting[next] = 1;
         }
+        if (proc->next_instruction >= proc->instruction_count) {
+            releaseAllResources(next);
+        }
+        if (available != availableBefore) {
+            std::fill(waiting, waiting + processCount, 0);  // Releases, grants and rollbacks can unblock anyone
+        }
+        steps++;
     }
+    return steps;
 }
 
+// Compares Banker's avoidance against detection-and-recovery for both schedulers
+void runBenchmark() {
+    const char* modeNames[] = {"Avoidance", "Detection"};
+    const char* schedulerNames[] = {"EDF", "LLF"};
+    verbose = 0;
+
+    printf("%-10s %-4s %12s %10s %10s %10s %10s %10s %10s %10s\n", "Mode", "Sch", "instr/sec", "granted",
+           "blocked", "safety", "detector", "rollbacks", "misses", "unfinished");
+    for (int mode = AVOIDANCE; mode <= DETECTION; mode++) {
+        for (int sched = EDF; sched <= LLF; sched++) {
+            currentDeadlockMode = (DeadlockMode)mode;
+            currentScheduler = (SchedulerType)sched;
+
+            DeadlockStats total;
+            memset(&total, 0, sizeof(total));
+            long misses = 0, unfinished = 0;
+            auto start = std::chrono::steady_clock::now();
+            for (int iteration = 0; iteration < BENCHMARK_ITERATIONS; iteration++) {
+                resetSimulationState();
+                runInterleaved();
+                total.instructionsExecuted += stats.instructionsExecuted;
+                total.requestsGranted += stats.requestsGranted;
+                total.requestsBlocked += stats.requestsBlocked;
+                total.safetyChecks += stats.safetyChecks;
+                total.detectorRuns += stats.detectorRuns;
+                total.rollbacks += stats.rollbacks;
+                for (int i = 0; i < processCount; i++) {
+                    misses += processes[i].deadline_misses;
+                    unfinished += processes[i].next_instruction < processes[i].instruction_count;
+                }
+            }
+            double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+            printf("%-10s %-4s %12.0f %10.2f %10.2f %10.2f %10.2f %10.2f %10.2f %10.2f\n",
+                   modeNames[mode], schedulerNames[sched], total.instructionsExecuted / seconds,
+                   (double)total.requestsGranted / BENCHMARK_ITERATIONS,
+                   (double)total.requestsBlocked / BENCHMARK_ITERATIONS,
+                   (double)total.safetyChecks / BENCHMARK_ITERATIONS,
+                   (double)total.detectorRuns / BENCHMARK_ITERATIONS,
+                   (double)total.rollbacks / BENCHMARK_ITERATIONS,
+                   (double)misses / BENCHMARK_ITERATIONS,
+                   (double)unfinished / BENCHMARK_ITERATIONS);
+        }
+    }
+    printf("(counts are averages per run over %d runs)\n", BENCHMARK_ITERATIONS);
+    verbose = 1;
+}
 
 
 
@@ -478,16 +1208,44 @@ void executeProcessInstructions(int processIndex) {
 int main(int argc, char *argv[]) {
     sem_init(&resourceAccess, 0, 1);
     sem_init(&scheduleAccess, 0, 1);
-    if (argc != 3) {
-        fprintf(stderr, "Usage: %s <operation_file> <word_file>\n", argv[0]);
+    if (argc != 3 && argc != 4) {
+        fprintf(stderr, "Usage: %s <operation_file> <word_file> [avoidance|detection|benchmark|precheck|parse]\n", argv[0]);
         return EXIT_FAILURE;
     }
 
     // Parse the operation file
+    auto parseStart = std::chrono::steady_clock::now();
     parseOperationFile(argv[1]);
     // Parse the word file
     parseWordFile(argv[2]);
+    double parseSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - parseStart).count();
+
+    if (argc == 4) {
+        if (strcmp(argv[3], "parse") == 0) {
+            // Parser throughput only
+            printf("Parsed %zu bytes in %.3f ms (%.1f MB/s)\n", bytesParsed, parseSeconds * 1000.0,
+                   bytesParsed / parseSeconds / 1e6);
+            return EXIT_SUCCESS;
+        } else if (strcmp(argv[3], "precheck") == 0) {
+            // Screening only: the exit status tells whether the task set is worth simulating
+            auto analysisStart = std::chrono::steady_clock::now();
+            SchedulabilityReport report = analyzeSchedulability();
+            auto analysisTime = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - analysisStart).count();
+            printSchedulabilityReport(&report);
+            printf("  Analysis took %.3f microseconds\n", analysisTime / 1000.0);
+            return report.demandFeasible && report.laxityFeasible ? EXIT_SUCCESS : EXIT_FAILURE;
+        } else if (strcmp(argv[3], "detection") == 0) {
+            currentDeadlockMode = DETECTION;
+        } else if (strcmp(argv[3], "benchmark") == 0) {
+            runBenchmark();
+            return EXIT_SUCCESS;
+        } else if (strcmp(argv[3], "avoidance") != 0) {
+            fprintf(stderr, "Unknown mode: %s\n", argv[3]);
+            return EXIT_FAILURE;
+        }
+    }
 
+    fflush(stdout); // Children would otherwise inherit and print the buffered report again
     pid_t pid;
     for (int i = 0; i < processCount; i++) {
         pid = fork();
@@ -17,6 +17,15 @@
 #include <cstring>
 #include <climits>
 #include <chrono>
+#include <thread>
+#include <atomic>
+#include <cstdint>
+#include <random>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <fcntl.h>
 
 // Data Structures
 struct PageTableEntry {
@@ -31,6 +40,10 @@ struct FrameTableEntry {
     int backward_link;
     int disk_address;
     int access_count;
+    int next_use; // Position of the page's next reference in its process's trace (OPT)
+    bool prefetched; // Loaded by readahead and not referenced yet
+    bool referenced; // Reference bit for the CLOCK family, set on every hit
+    bool dirty; // Written since it was loaded: eviction writes it back
 };
 
 struct DiskQueueEntry {
@@ -38,6 +51,54 @@ struct DiskQueueEntry {
     char operation;
     int frame_index;
     int disk_addr;
+    long issue_clock; // Disk clock when the request was queued
+    std::vector<int> readahead_frames; // Prefetched frames read along with frame_index in one clustered request
+    int cluster_end; // Highest track the request touches
+    int write_pages; // Pages a 'W' request writes back, more than one once the driver has coalesced it
+};
+
+// Per-process sequential access detector. Consecutive faults `stride` pages apart open a readahead
+// window that doubles while the stream continues and halves whenever a prefetched page is evicted unused.
+struct ReadaheadState {
+    int last_fault = -1;
+    int stride = 0;
+    int next_expected = -1; // Page where the next fault lands if the stream continues past the window
+    int window = 0;
+};
+
+// The last `delta` pages a process referenced, on its own virtual time, kept in a ring together with
+// how often each page occurs in it. A page is in the working set while its count is non-zero, so
+// every reference updates the set in O(1).
+struct WorkingSetWindow {
+    std::vector<int> ring;
+    int next = 0;
+    std::unordered_map<int, int> counts;
+
+    explicit WorkingSetWindow(int delta = 1) : ring(std::max(delta, 1), -1) {}
+
+    bool full() const { return ring[next] != -1; }
+    int size() const { return counts.size(); }
+    bool contains(int page_number) const { return counts.count(page_number) != 0; }
+
+    // Records a reference; returns the page whose last occurrence just slid out of the window, or -1
+    int push(int page_number) {
+        int departing = ring[next];
+        ring[next] = page_number;
+        next = (next + 1) % ring.size();
+        counts[page_number]++;
+        if (departing == -1) return -1;
+        auto it = counts.find(departing);
+        if (--it->second > 0) return -1;
+        counts.erase(it);
+        return departing;
+    }
+};
+
+// Page-fault-frequency controller state of one process
+struct PffState {
+    int last_fault = 0; // Virtual time (references made) of the previous fault
+    int min_frames = INT_MAX, max_frames = 0;
+    long grows = 0, shrinks = 0, released = 0;
 };
 
 struct DiskPage {
@@ -45,60 +106,756 @@ struct DiskPage {
     int trackNum;
 };
 
-struct MemoryAddress {
-    unsigned int address;
+// Insertion-ordered set with O(1) push, erase by key and pop of the oldest element. Used for the
+// frame queues and the ghost (recently evicted page) lists of CLOCK-Pro, 2Q and ARC.
+template <typename Key>
+class LinkedSet {
+public:
+    bool contains(const Key& key) const { return positions.count(key) != 0; }
+    bool empty() const { return order.empty(); }
+    size_t size() const { return order.size(); }
+    const Key& front() const { return order.front(); }
+
+    void push_back(const Key& key) {
+        order.push_back(key);
+        positions[key] = std::prev(order.end());
+    }
+
+    bool erase(const Key& key) {
+        auto it = positions.find(key);
+        if (it == positions.end()) return false;
+        order.erase(it->second);
+        positions.erase(it);
+        return true;
+    }
+
+    Key pop_front() {
+        Key key = order.front();
+        erase(key);
+        return key;
+    }
+
+    // Oldest element satisfying pred, or nullptr
+    template <typename Pred>
+    const Key* find_first(Pred pred) const {
+        for (const Key& key : order) {
+            if (pred(key)) return &key;
+        }
+        return nullptr;
+    }
+
+private:
+    std::list<Key> order;
+    std::unordered_map<Key, typename std::list<Key>::iterator> positions;
+};
+
+// Log-linear histogram in the style of HdrHistogram: values below 2^SUB_BUCKET_BITS are counted
+// exactly, larger ones by their highest SUB_BUCKET_BITS + 1 bits, so every value is kept within
+// about 3% in a few hundred counters however large it gets
+class Histogram {
+public:
+    void record(long value) {
+        value = std::max(value, 0L);
+        size_t bucket = index(value);
+        if (bucket >= counts.size()) counts.resize(bucket + 1, 0);
+        counts[bucket]++;
+        total++;
+        sum += value;
+        lowest = total == 1 ? value : std::min(lowest, value);
+        highest = std::max(highest, value);
+    }
+
+    long count() const { return total; }
+    long min() const { return lowest; }
+    long max() const { return highest; }
+    double mean() const { return total > 0 ? static_cast<double>(sum) / total : 0.0; }
+
+    // Highest value equivalent to the one at the given percentile (0-100)
+    long percentile(double p) const {
+        if (total == 0) return 0;
+        long rank = std::max<long>(1, static_cast<long>(p / 100.0 * total + 0.5));
+        long seen = 0;
+        for (size_t bucket = 0; bucket < counts.size(); bucket++) {
+            seen += counts[bucket];
+            if (seen >= rank) return std::min(highest, upperBound(bucket));
+        }
+        return highest;
+    }
+
+private:
+    static constexpr int SUB_BUCKET_BITS = 5;
+    static constexpr long SUB_BUCKETS = 1L << SUB_BUCKET_BITS;
+
+    static size_t index(long value) {
+        if (value < SUB_BUCKETS) return value;
+        int shift = (63 - __builtin_clzl(value)) - SUB_BUCKET_BITS;
+        return SUB_BUCKETS * (shift + 1) + ((value >> shift) - SUB_BUCKETS);
+    }
+
+    static long upperBound(size_t bucket) {
+        if ((long)bucket < SUB_BUCKETS) return bucket;
+        long shift = bucket / SUB_BUCKETS - 1;
+        return ((SUB_BUCKETS + (long)bucket % SUB_BUCKETS + 1) << shift) - 1;
+    }
+
+    std::vector<long> counts;
+    long total = 0, sum = 0, lowest = 0, highest = 0;
+};
+
+// What one disk scheduling + page replacement run measured, for --json and --csv
+struct RunMetrics {
+    std::string disk_algorithm, page_algorithm;
+    long references = 0, faults = 0, evictions = 0;
+    long reclaim_stalls = 0, daemon_evictions = 0, readahead_pages = 0;
+    long writeback_pages = 0, write_operations = 0; // Dirty pages evicted, and the disk writes they took
+    long simulated_disk_time = 0; // Microseconds
+    Histogram fault_service; // Simulated microseconds from queuing a read to its completion
+    Histogram queue_wait; // Simulated microseconds a request waited before the head started on it
+    Histogram seek_distance; // Tracks per request
+};
+
+// LFU frequency bucket: frames referenced exactly `frequency` times, oldest arrival first
+struct FrequencyBucket {
+    int frequency;
+    std::list<int> frames;
+};
+
+// Identifies a page across processes in the ghost lists
+inline uint64_t pageKey(int process_id, int page_number) {
+    return ((uint64_t)(uint32_t)process_id << 32) | (uint32_t)page_number;
+}
+
+enum TlbReplacement { TLB_LRU, TLB_FIFO, TLB_RANDOM };
+
+struct TlbEntry {
+    int asid; // Owning process, -1 when the entry is invalid
+    int page_number;
+    int frame_number;
+    long stamp; // Last use (LRU) or fill time (FIFO)
+};
+
+// One set-associative TLB level. A page maps to set page % sets and may sit in any of its ways.
+struct TlbLevel {
+    int sets = 0, ways = 0;
+    TlbReplacement replacement = TLB_LRU;
+    std::vector<TlbEntry> entries;
+    long clock = 0;
+    unsigned int random_state = 2463534242u;
+
+    void configure(int entry_count, int associativity, TlbReplacement policy) {
+        if (entry_count <= 0) return;
+        ways = std::max(1, std::min(associativity, entry_count));
+        sets = std::max(1, entry_count / ways);
+        replacement = policy;
+        entries.assign(sets * ways, {-1, -1, -1, 0});
+    }
+
+    bool enabled() const { return sets > 0; }
+
+    TlbEntry* find(int asid, int page_number) {
+        TlbEntry* set = &entries[(page_number % sets) * ways];
+        for (int way = 0; way < ways; way++) {
+            if (set[way].asid == asid && set[way].page_number == page_number) return &set[way];
+        }
+        return nullptr;
+    }
+
+    // Returns the cached frame, or -1 on a miss
+    int lookup(int asid, int page_number) {
+        TlbEntry* entry = find(asid, page_number);
+        if (entry == nullptr) return -1;
+        if (replacement == TLB_LRU) entry->stamp = ++clock;
+        return entry->frame_number;
+    }
+
+    void insert(int asid, int page_number, int frame_number) {
+        TlbEntry* set = &entries[(page_number % sets) * ways];
+        TlbEntry* victim = &set[0];
+        for (int way = 0; way < ways; way++) {
+            if (set[way].asid == -1) { victim = &set[way]; break; }
+            if (set[way].stamp < victim->stamp) victim = &set[way];
+        }
+        if (replacement == TLB_RANDOM && victim->asid != -1) {
+            random_state ^= random_state << 13;
+            random_state ^= random_state >> 17;
+            random_state ^= random_state << 5;
+            victim = &set[random_state % ways];
+        }
+        *victim = {asid, page_number, frame_number, ++clock};
+    }
+
+    void invalidate(int asid, int page_number) {
+        TlbEntry* entry = find(asid, page_number);
+        if (entry != nullptr) entry->asid = -1;
+    }
+
+    void flush() {
+        for (auto& entry : entries) entry.asid = -1;
+    }
+};
+
+struct TlbStats {
+    long references = 0, l1_hits = 0, l2_hits = 0, walks = 0, cycles = 0;
+};
+
+int getDiskAddress(int process_id, int page_number);
+
+// One process's page table. probe() reports how many table memory accesses a lookup makes, which
+// walk() accumulates as the lookup cost; find() is the simulator's own uncounted lookup. Entries
+// are created on first mapping with the page's disk address.
+class PageTable {
+public:
+    PageTable(int process_id, long long page_limit) : process_id(process_id), page_limit(page_limit) {}
+    virtual ~PageTable() = default;
+
+    virtual size_t footprint() const = 0; // Bytes currently allocated
+
+    bool covers(int page_number) const { return page_number >= 0 && page_number < page_limit; }
+
+    PageTableEntry* find(int page_number) {
+        int touched;
+        return probe(page_number, touched);
+    }
+
+    PageTableEntry* walk(int page_number) {
+        int touched;
+        PageTableEntry* entry = probe(page_number, touched);
+        lookups++;
+        accesses += touched;
+        return entry;
+    }
+
+    PageTableEntry& entry(int page_number) {
+        PageTableEntry& entry = slot(page_number);
+        if (entry.disk_address == -1) entry.disk_address = getDiskAddress(process_id, page_number);
+        return entry;
+    }
+
+    int process_id;
+    long long page_limit; // Pages the table can map
+    long lookups = 0, accesses = 0;
+
+protected:
+    virtual PageTableEntry* probe(int page_number, int& touched) = 0; // nullptr if never mapped
+    virtual PageTableEntry& slot(int page_number) = 0; // Creates the entry if needed
+};
+
+// The original layout: one entry per page of the process's declared size, a single access per lookup
+class DensePageTable : public PageTable {
+public:
+    DensePageTable(int process_id, int pages) : PageTable(process_id, pages), entries(pages, {-1, -1}) {}
+
+    size_t footprint() const override { return entries.size() * sizeof(PageTableEntry); }
+
+protected:
+    PageTableEntry* probe(int page_number, int& touched) override {
+        touched = 1;
+        return &entries[page_number];
+    }
+
+    PageTableEntry& slot(int page_number) override { return entries[page_number]; }
+
+private:
+    std::vector<PageTableEntry> entries;
+};
+
+// Multi-level table over the whole address space, RADIX_BITS of the page number per level. Nodes
+// are allocated the first time a page under them is mapped; a lookup touches one node per level.
+class RadixPageTable : public PageTable {
+public:
+    static constexpr int RADIX_BITS = 9;
+    static constexpr int FANOUT = 1 << RADIX_BITS;
+
+    RadixPageTable(int process_id, long long page_limit) : PageTable(process_id, page_limit) {
+        levels = 1;
+        while (levels < 4 && (1LL << (levels * RADIX_BITS)) < page_limit) levels++;
+        if (levels > 1) interior.emplace_back(FANOUT, -1);
+        else leaves.emplace_back(FANOUT, PageTableEntry{-1, -1});
+    }
+
+    size_t footprint() const override {
+        return interior.size() * FANOUT * sizeof(int) + leaves.size() * FANOUT * sizeof(PageTableEntry);
+    }
+
+protected:
+    PageTableEntry* probe(int page_number, int& touched) override {
+        touched = levels;
+        int node = 0;
+        for (int level = levels - 1; level > 0; level--) {
+            node = interior[node][index(page_number, level)];
+            if (node == -1) {
+                touched = levels - level;
+                return nullptr;
+            }
+        }
+        PageTableEntry& entry = leaves[node][index(page_number, 0)];
+        return entry.frame_number == -1 && entry.disk_address == -1 ? nullptr : &entry;
+    }
+
+    PageTableEntry& slot(int page_number) override {
+        int node = 0;
+        for (int level = levels - 1; level > 0; level--) {
+            int& child = interior[node][index(page_number, level)];
+            if (child == -1) {
+                // Children of the last interior level are leaves
+                if (level == 1) {
+                    child = leaves.size();
+                    leaves.emplace_back(FANOUT, PageTableEntry{-1, -1});
+                } else {
+                    child = interior.size();
+                    interior.emplace_back(FANOUT, -1);  // May reallocate `interior`; child is not used after
+                }
+            }
+            node = interior[node][index(page_number, level)];
+        }
+        return leaves[node][index(page_number, 0)];
+    }
+
+private:
+    static int index(int page_number, int level) { return (page_number >> (level * RADIX_BITS)) & (FANOUT - 1); }
+
+    int levels;
+    std::vector<std::vector<int>> interior; // Child node indexes, -1 when absent; interior[0] is the root
+    std::vector<std::vector<PageTableEntry>> leaves;
+};
+
+// Hashed table: open addressing with linear probing on the page number, grown at 3/4 load, so its
+// size follows the pages actually mapped. A lookup costs one access per probe.
+class HashedPageTable : public PageTable {
+public:
+    HashedPageTable(int process_id, long long page_limit) : PageTable(process_id, page_limit) {
+        resize(64);
+    }
+
+    size_t footprint() const override { return keys.size() * (sizeof(int) + sizeof(PageTableEntry)); }
+
+protected:
+    PageTableEntry* probe(int page_number, int& touched) override {
+        touched = 0;
+        for (size_t i = home(page_number); ; i = (i + 1) & (keys.size() - 1)) {
+            touched++;
+            if (keys[i] == page_number) return &values[i];
+            if (keys[i] == -1) return nullptr;
+        }
+    }
+
+    PageTableEntry& slot(int page_number) override {
+        if ((used + 1) * 4 > keys.size() * 3) resize(keys.size() * 2);
+        size_t i = home(page_number);
+        while (keys[i] != -1 && keys[i] != page_number) i = (i + 1) & (keys.size() - 1);
+        if (keys[i] == -1) {
+            keys[i] = page_number;
+            values[i] = {-1, -1};
+            used++;
+        }
+        return values[i];
+    }
+
+private:
+    // Fibonacci hashing: the top bits of page * 2^32/phi
+    size_t home(int page_number) const { return ((uint32_t)page_number * 2654435769u) >> shift; }
+
+    void resize(size_t capacity) {
+        std::vector<int> old_keys(capacity, -1);
+        std::vector<PageTableEntry> old_values(capacity);
+        old_keys.swap(keys);
+        old_values.swap(values);
+        shift = 32;
+        for (size_t c = capacity; c > 1; c >>= 1) shift--;
+        used = 0;
+        for (size_t i = 0; i < old_keys.size(); i++) {
+            if (old_keys[i] != -1) slot(old_keys[i]) = old_values[i];
+        }
+    }
+
+    std::vector<int> keys; // -1 marks an empty slot
+    std::vector<PageTableEntry> values;
+    size_t used = 0;
+    int shift = 32;
+};
+
+// A process's address trace, stored as zigzag varint deltas between consecutive addresses so a
+// sequential trace takes about a byte per reference. Text input is encoded into `owned`; a binary
+// trace file points `mapped` straight into the mapping and is never copied.
+struct AddressTrace {
+    std::vector<unsigned char> owned;
+    const unsigned char* mapped = nullptr;
+    size_t bytes = 0;
+    size_t count = 0;
+    unsigned int last_address = 0; // Previous address appended, the base of the next delta
+
+    const unsigned char* data() const { return mapped != nullptr ? mapped : owned.data(); }
+    size_t size() const { return count; }
+
+    // The zigzag delta is shifted left once more to make room for the write bit
+    void append(unsigned int address, bool write = false) {
+        int64_t delta = (int64_t)address - last_address;
+        uint64_t zigzag = ((uint64_t)delta << 1) ^ (uint64_t)(delta >> 63);
+        uint64_t value = (zigzag << 1) | (write ? 1 : 0);
+        while (value >= 0x80) {
+            owned.push_back((unsigned char)(value | 0x80));
+            value >>= 7;
+        }
+        owned.push_back((unsigned char)value);
+        bytes = owned.size();
+        last_address = address;
+        count++;
+    }
+};
+
+// Decodes a trace front to back; each user keeps its own cursor, so threads can share the trace
+struct TraceCursor {
+    const unsigned char* position;
+    unsigned int address = 0;
+    bool write = false; // Whether the reference next() returned last is a write
+
+    explicit TraceCursor(const AddressTrace& trace) : position(trace.data()) {}
+
+    unsigned int next() {
+        uint64_t value = 0;
+        int shift = 0;
+        unsigned char byte;
+        do {
+            byte = *position++;
+            value |= (uint64_t)(byte & 0x7f) << shift;
+            shift += 7;
+        } while (byte & 0x80);
+        write = value & 1;
+        uint64_t zigzag = value >> 1;
+        int64_t delta = (int64_t)(zigzag >> 1) ^ -(int64_t)(zigzag & 1);
+        address = (unsigned int)(address + delta);
+        return address;
+    }
+};
+
+// Replay state of one process: where it is in its trace and, under an interleaving CPU scheduler,
+// the frame whose read it is blocked on
+struct ProcessContext {
+    int process_id;
+    TraceCursor cursor;
+    const std::vector<int>* next_use;
+    int position = 0; // References made so far, the process's virtual time
+    int size;
+    int faults = 0;
+    int blocked_frame = -1;
+
+    ProcessContext(int process_id, const AddressTrace& trace, const std::vector<int>& next_use)
+            : process_id(process_id), cursor(trace), next_use(&next_use), size(trace.size()) {}
+    bool finished() const { return position >= size; }
+};
+
+// Binary trace file: header, configuration entries, one entry per process, then each process's
+// page->track table and encoded addresses at the offsets its entry gives
+const char BINARY_TRACE_MAGIC[4] = {'P', 'A', '3', 'T'};
+const uint32_t BINARY_TRACE_VERSION = 2; // 2: references carry a write bit
+
+struct BinaryTraceHeader {
+    char magic[4];
+    uint32_t version;
+    uint32_t config_count;
+    uint32_t process_count;
+};
+
+struct BinaryConfigEntry {
+    char key[12];
+    int32_t value;
+};
+
+struct BinaryProcessEntry {
+    int32_t process_id;
+    int32_t pages;
+    uint64_t track_offset; // pages x DiskPage
+    uint64_t references;
+    uint64_t address_offset;
+    uint64_t address_bytes;
 };
 
+// Pending disk requests indexed by track; requests on the same track keep their arrival order
+using TrackIndex = std::multimap<int, std::list<DiskQueueEntry>::iterator>;
+
 struct ProcessDiskInfo {
     int process_id;
     int total_pages;
     std::vector<DiskPage> pages;
 };
 
+// Configuration and traces, read once and shared read-only by every simulation run
 std::unordered_map<int, int> pagesPerProcess; // Stores number of pages for each process
-std::unordered_map<int, std::pair<int, int>> working_set_sizes; // Store working set sizes for each process
-std::unique_ptr<FrameTableEntry[]> frame_table;
-std::unique_ptr<std::unique_ptr<PageTableEntry[]>[]> page_tables;
+std::unordered_map<int, int> processPriority; // From prio<pid> lines, 1 when absent
+std::map<int, int> frameQuota; // Frames each process is allocated, filled by computeFrameQuotas
+std::vector<std::string> allocationPolicyNames = {"none", "equal", "proportional", "priority"};
 std::unordered_map<int, std::vector<DiskPage>> diskPages;
-std::unordered_map<int, std::vector<MemoryAddress>> memoryAddresses;
-std::unordered_map<int, std::deque<int>> accessHistory;
-std::vector<std::string> diskSchedulingNames = {"FIFO", "SSTF", "SCAN"};
-std::vector<std::string> pageReplacementNames = {"LIFO", "LRU", "MRU", "LFU", "OPT", "WS"};
-std::list<DiskQueueEntry> diskQueue;
+std::unordered_map<int, AddressTrace> memoryAddresses;
+std::vector<std::string> diskSchedulingNames = {"FIFO", "SSTF", "SCAN", "C-SCAN", "LOOK", "C-LOOK"};
+std::vector<std::string> pageReplacementNames = {"LIFO", "LRU", "MRU", "LFU", "OPT", "OPT-X", "WS",
+                                                 "CLOCK", "CLOCK-Pro", "2Q", "ARC"};
 std::map<std::string, std::map<int, int>> pageFaultsPerAlgorithm;
 std::map<std::string, int> totalPageFaultsPerAlgorithm;
-sem_t disk_semaphore, queue_sem;
+std::map<std::string, std::unordered_map<int, std::pair<int, int>>> workingSetSizesPerAlgorithm;
 std::chrono::steady_clock::time_point current_time = std::chrono::steady_clock::now();
-int total_seek_operations = 0, total_seek_distance = 0;
 int total_frames = 0, page_size = 0, frames_per_process = 0;
 int lookahead_window_size = 0, min_free_pool_size = 0, max_free_pool_size = 0;
 int total_processes = 0, max_disk_track = 0, disk_queue_length = 0;
-int current_head_position = 0, total_page_faults = 0;
+// Disk cost model in microseconds of simulated time: seek per track crossed, rotational latency and
+// transfer time per page. The defaults match the old usleep timing (100 us per track, 10 us overhead).
+int seek_time_per_track = 100, rotational_latency = 5, transfer_time = 5;
+bool realtime_pacing = false; // Sleep for each simulated disk operation (demos only)
+int verbosity = 0; // --verbose: 1 logs every replacement, 2 also every disk request
+double sample_rate = 1.0; // --sample: fraction of pages kept by spatial sampling, 1 keeps the whole trace
+std::vector<RunMetrics> runMetrics; // One per algorithm pair, in matrix order
+int readahead_max = 0; // Largest readahead window in pages, 0 (default) disables readahead
+// TLB model: entries and ways per level (0 entries disables a level), replacement, whether entries
+// carry an ASID or the TLB is flushed on every process switch, and the translation cost in cycles
+int tlb_entries = 64, tlb_ways = 4, tlb2_entries = 512, tlb2_ways = 8;
+int tlb_replacement = TLB_LRU, tlb_asid_tagged = 1;
+int tlb_hit_cycles = 1, tlb2_hit_cycles = 7, page_walk_cycles = 30;
+std::vector<std::string> pageTableNames = {"dense", "radix", "hashed"};
+int page_table_kind = 0; // Index into pageTableNames
+int lfu_aging_interval = 0; // LFU halves every count each time this many references were made, 0 never
+int working_set_window = 100; // Working-set delta in references
+int pff_threshold = 0; // PFF: faults closer than this many references grow the allocation, 0 disables PFF
+int allocation_policy = 0; // Index into allocationPolicyNames
+int cpu_scheduler = 0; // 0 replays each process to completion, 1 round robin, 2 run until the process faults
+int cpu_quantum = 100; // Round-robin time slice in references
+int reference_time = 1; // Simulated microseconds of CPU per reference
+int replacement_scope = 0; // 0 global, 1 local
+const int NEVER_USED_AGAIN = INT_MAX;
+std::unordered_map<int, std::vector<int>> nextUse; // nextUse[pid][i]: next position referencing the page at i
+std::unordered_map<int, std::unordered_map<int, int>> firstUse; // firstUse[pid][page]: first position referencing page
 
 
 // Function declarations
-void initializeGlobals();
 void readConfiguration(const char *filename);
-void initializeSemaphores();
-void initFrameTable(int total_frames);
-void diskDriverProcess();
-void requestPageFromDisk(int frame_index, int disk_addr, int process_id);
-void processDiskRequest(const DiskQueueEntry& request, const std::string& algorithmName);
-void fifoDiskScheduling(const std::string& algorithmName);
-void sstfDiskScheduling(const std::string& algorithmName);
-void scanDiskScheduling(const std::string& algorithmName);
 int extractPageNumber(unsigned int address, int page_size);
-int findFreeFrame();
 int getDiskAddress(int process_id, int page_number);
-void lifoPageReplacement(int process_id);
-void lruPageReplacement(int process_id);
-void lruXPageReplacement(int process_id, int X);
-void mruPageReplacement(int process_id);
-void lfuPageReplacement(int process_id);
-void optLookaheadPageReplacement(int process_id, int X);
-void workingSetPageReplacement(int process_id, int delta);
+bool isValidFrameIndex(int frame_index);
+void buildNextUseIndex();
+void computeFrameQuotas();
+void runAllAlgorithmPairs();
+void applySpatialSampling(double rate);
+void checkSampling(double rate);
+void runBenchmark();
+void writeMetricsJson(const char* filename);
+void writeMetricsCsv(const char* filename);
 void simulatePageFaultsAndOutputResults(const char* filename);
 
+// All mutable state of one disk scheduling + page replacement run. Runs share nothing but the
+// read-only configuration and traces above, so they can execute on separate threads and one
+// run's frames, queue or head position never leak into the next.
+class Simulation {
+public:
+    Simulation(int disk_algorithm, int page_algorithm);
+    ~Simulation();
+
+    void initializePageTables();
+    void initializeSemaphores();
+    void initFrameTable(int total_frames);
+    void diskDriverProcess();
+    void populateDiskQueue();
+    void scheduleDiskIO(DiskQueueEntry* entry);
+    void lockDiskQueue();
+    void unlockDiskQueue();
+    bool admitDiskRequests();
+    void servicePending(TrackIndex::iterator next, const std::string& algorithmName);
+    void completeDiskRequest(const DiskQueueEntry& request);
+    void catchUpDisk();
+    void waitForCompletion();
+    void waitForQueueSlot();
+    void waitForDiskRead(int frame_index);
+    void startDiskDriver();
+    void stopDiskDriver();
+    void requestPageFromDisk(int frame_index, int disk_addr, int process_id, const std::vector<int>& readahead_frames = {});
+    void requestWriteBack(int frame_index);
+    std::vector<int> readaheadPages(int process_id, int page_number);
+    void translateAddress(int process_id, int page_number);
+    void tlbFill(int process_id, int page_number, int frame_index);
+    void tlbSwitchTo(int process_id);
+    void processDiskRequest(const DiskQueueEntry& request, const std::string& algorithmName);
+    long calculateServiceTime(int disk_addr);
+    void fifoDiskScheduling(const std::string& algorithmName);
+    void sstfDiskScheduling(const std::string& algorithmName);
+    void scanDiskScheduling(const std::string& algorithmName);
+    void cscanDiskScheduling(const std::string& algorithmName);
+    void lookDiskScheduling(const std::string& algorithmName);
+    void clookDiskScheduling(const std::string& algorithmName);
+    void moveHead(int track);
+    void sweepDiskScheduling(const std::string& algorithmName, bool to_edge, bool circular);
+    int findFreeFrame();
+    void lruUnlink(int frame_index);
+    void lruPushMostRecent(int frame_index);
+    void lruTouch(int frame_index);
+    void installPage(int frame_index, int process_id, int page_number);
+    void evictFrame(int frame_index);
+    bool evictable(int frame_index);
+    bool reclaimFrame(int process_id);
+    void refillFreePool(int process_id);
+    void lifoPageReplacement(int process_id);
+    void lruPageReplacement(int process_id);
+    void lruXPageReplacement(int process_id, int X);
+    void mruPageReplacement(int process_id);
+    void lfuPageReplacement(int process_id);
+    void optSetNextUse(int frame_index, int next_use);
+    void optResetQueue(int process_id);
+    void optPageReplacement(int process_id);
+    void optLookaheadPageReplacement(int process_id, int X);
+    void workingSetPageReplacement(int process_id);
+    void workingSetReference(int process_id, int page_number);
+    void workingSetRetire(int process_id);
+    void pffFault(int process_id);
+    void optPageReplacementWrapper(int process_id);
+    void optLookaheadPageReplacementWrapper(int process_id);
+    void clockPageReplacement(int process_id);
+    void clockProPageReplacement(int process_id);
+    void clockProRunHotHand();
+    void twoQueuePageReplacement(int process_id);
+    void arcPageReplacement(int process_id);
+    void lfuInsert(int frame_index);
+    void lfuTouch(int frame_index);
+    void lfuRemove(int frame_index);
+    void lfuAge();
+    void policyInstall(int frame_index);
+    void policyForget(int frame_index);
+    void handlePageFaults(int process_id, const std::string& algorithmName);
+    int replayReference(ProcessContext& process);
+    void finishProcess(ProcessContext& process, const std::string& algorithmName);
+    void replayInterleaved(const std::string& algorithmName);
+    void outputResultsForAlgorithmPair(const std::string& algorithmName);
+    void simulateAlgorithmPair();
+
+    int disk_algorithm, page_algorithm; // Indexes into the scheduling and replacement tables
+    std::string algorithmName;
+    std::ostringstream log; // Everything this run prints, written out in order once all runs finish
+    RunMetrics metrics;
+    std::map<int, int> pageFaults; // Faults per process
+    std::unordered_map<int, std::pair<int, int>> working_set_sizes; // Store working set sizes for each process
+    std::unique_ptr<FrameTableEntry[]> frame_table;
+    std::vector<std::unique_ptr<PageTable>> page_tables; // Indexed by process id
+    std::unordered_map<int, std::deque<int>> accessHistory;
+    std::list<DiskQueueEntry> diskQueue; // Issued requests the driver has not admitted yet, in issue order
+    // disk_semaphore guards diskQueue and the hand-over state below; request_sem wakes the driver and
+    // io_done_sem is posted after every completed request
+    sem_t disk_semaphore, request_sem, io_done_sem;
+    std::thread disk_driver;
+    bool driver_stopping = false;
+    std::vector<int> pending_reads; // Per frame: reads queued or in service
+    // Every request issued before issue_horizon (simulated time) has been queued. While the replay
+    // waits for a queue slot or for one of awaited_frames to be read, it issues nothing before that
+    // completion, so the driver may go on choosing past the horizon.
+    long issue_horizon = 0;
+    bool awaiting_slot = false;
+    std::vector<int> awaited_frames;
+    long outstanding_requests = 0; // Queue slots taken: requests queued, pending or in service
+    long settled_clock = 0; // disk_clock when the driver last completed a request or went idle
+    long last_completion_clock = 0;
+    int last_completion_slots = 0;
+    // Driver thread only: admitted requests in arrival order, and the same requests by track
+    std::list<DiskQueueEntry> disk_pending;
+    TrackIndex pending_tracks;
+    std::ostringstream disk_log; // Written only by the driver thread, appended to log once it stops
+    // Per-event messages go through events (simulation thread) and diskEvents (driver thread), which
+    // drop them unless --verbose reaches their level
+    std::ostream null_log{nullptr}, null_disk_log{nullptr};
+    std::ostream& events(int level) { return verbosity >= level ? static_cast<std::ostream&>(log) : null_log; }
+    std::ostream& diskEvents(int level) { return verbosity >= level ? static_cast<std::ostream&>(disk_log) : null_disk_log; }
+    long queued_requests = 0, queue_depth_sum = 0, total_io_wait = 0;
+    long scheduler_picks = 0; // Requests the driver chose; queue depth is sampled at every choice
+    int max_queue_depth = 0;
+    long blocked_reads = 0, blocked_time = 0; // References that waited on an in-flight read, and simulated time waited
+    int total_seek_operations = 0, total_seek_distance = 0;
+    int current_head_position = 0, total_page_faults = 0;
+    long disk_clock = 0; // Simulated time in microseconds, advanced by the driver as it services requests
+    int head_direction = 1; // +1 while the head sweeps towards higher tracks, -1 towards track 0
+    int lru_head = -1, lru_tail = -1; // Recency list threaded through frame_table links, head is least recently used
+    std::set<std::pair<int, int>> optQueue; // (next_use, frame) of resident frames, largest next use last
+    int current_reference = 0; // Position in the trace of the process being replayed
+    // CPU time in simulated microseconds, and when each frame's last read completed
+    bool interleaved = false;
+    long cpu_clock = 0, cpu_busy = 0;
+    long context_switches = 0, fault_blocks = 0;
+    std::vector<long> read_done_at;
+    std::vector<int> lifoStack; // Vector to simulate stack behavior for LIFO
+    bool tracks_load_order = false; // LIFO runs push every loaded frame onto lifoStack
+    std::string policy_name; // pageReplacementNames[page_algorithm]
+    uint64_t faulting_key = UINT64_MAX; // pageKey of the page being faulted in, for ARC's REPLACE
+    int clock_hand = 0;
+    // CLOCK-Pro: resident hot and cold pages in hand order, cold pages in their test period, and
+    // non-resident cold pages still in test. cold_target adapts between 1 and tp - 1.
+    LinkedSet<int> clock_pro_hot, clock_pro_cold;
+    std::vector<char> clock_pro_in_test;
+    LinkedSet<uint64_t> clock_pro_ghosts;
+    int cold_target = 1;
+    // 2Q: A1in (FIFO of pages seen once), Am (LRU of pages re-referenced) and A1out (ghosts of A1in)
+    LinkedSet<int> two_queue_in, two_queue_main;
+    LinkedSet<uint64_t> two_queue_out;
+    // ARC: T1 (seen once) and T2 (seen again) resident in LRU order, ghosts B1/B2, target size of T1
+    LinkedSet<int> arc_t1, arc_t2;
+    LinkedSet<uint64_t> arc_b1, arc_b2;
+    double arc_target = 0;
+    // LFU: buckets in ascending frequency, each frame's bucket and position in it
+    std::list<FrequencyBucket> lfu_buckets;
+    std::vector<std::list<FrequencyBucket>::iterator> lfu_bucket;
+    std::vector<std::list<int>::iterator> lfu_position;
+    std::vector<char> lfu_queued;
+    long lfu_references = 0;
+    // WS: each process's window, and resident frames whose page has left its owner's working set
+    bool tracks_working_set = false;
+    std::map<int, WorkingSetWindow> working_sets;
+    LinkedSet<int> ws_outside;
+    // PFF: frames each process holds, and the virtual time every frame was last referenced
+    std::map<int, int> resident_frames;
+    std::map<int, int> frame_quota; // This run's copy of frameQuota, so runs never touch the shared map
+    std::vector<int> frame_last_reference;
+    std::map<int, PffState> pff_state;
+    // Which frames the policy running now may evict: only replacement_owner's when it is set,
+    // otherwise only those of processes above their quota when victims_over_quota is set
+    int replacement_owner = -1;
+    bool victims_over_quota = false;
+    int free_frame_count = 0;
+    int reclaim_stalls = 0; // Faults that found the free pool empty and had to run replacement inline
+    int daemon_runs = 0, daemon_evictions = 0;
+    bool uses_readahead = false;
+    std::unordered_map<int, ReadaheadState> readahead_state;
+    long readahead_pages = 0, readahead_used = 0, readahead_wasted = 0;
+    long writeback_pages = 0; // Dirty pages evicted
+    long write_operations = 0, write_time = 0; // Driver thread: write requests serviced after coalescing, and their disk time
+    TlbLevel tlb, tlb2;
+    int tlb_asid = -1; // Process whose translations the TLB currently holds when entries are not tagged
+    long tlb_flushes = 0;
+    std::map<int, TlbStats> tlb_stats; // Per process
+};
+
+// Policy tables indexed by diskSchedulingNames / pageReplacementNames, defined after the policies
+extern void (Simulation::*diskSchedulingAlgorithms[])(const std::string&);
+extern void (Simulation::*pageReplacementAlgorithms[])(int);
+
+Simulation::Simulation(int disk_algorithm, int page_algorithm)
+        : disk_algorithm(disk_algorithm), page_algorithm(page_algorithm),
+          algorithmName(diskSchedulingNames[disk_algorithm] + " + " + pageReplacementNames[page_algorithm]) {
+    initializePageTables();
+    initializeSemaphores();
+    initFrameTable(total_frames);
+    frame_quota = frameQuota;
+    tracks_load_order = pageReplacementNames[page_algorithm] == "LIFO";
+    policy_name = pageReplacementNames[page_algorithm];
+    clock_pro_in_test.assign(total_frames, 0);
+    lfu_bucket.resize(total_frames);
+    lfu_position.resize(total_frames);
+    lfu_queued.assign(total_frames, 0);
+    tracks_working_set = policy_name == "WS";
+    frame_last_reference.assign(total_frames, 0);
+    interleaved = cpu_scheduler != 0;
+    read_done_at.assign(total_frames, 0);
+    // OPT's next-use oracle only covers pages loaded on demand, so it replays without readahead
+    uses_readahead = readahead_max > 0 && pageReplacementNames[page_algorithm].find("OPT") == std::string::npos;
+    tlb.configure(tlb_entries, tlb_ways, static_cast<TlbReplacement>(tlb_replacement));
+    if (tlb.enabled()) tlb2.configure(tlb2_entries, tlb2_ways, static_cast<TlbReplacement>(tlb_replacement));
+}
+
+Simulation::~Simulation() {
+    sem_destroy(&disk_semaphore);
+    sem_destroy(&request_sem);
+    sem_destroy(&io_done_sem);
+}
 
 
 void handleConfiguration(const std::string& key, int value) {
@@ -130,18 +887,88 @@ void handleConfiguration(const std::string& key, int value) {
     } else if (key == "y") {
         disk_queue_length = value;
         std::cout << "Disk queue length set to: " << disk_queue_length << std::endl;
+    } else if (key == "seek") {
+        seek_time_per_track = value;
+        std::cout << "Seek time per track set to: " << seek_time_per_track << " us" << std::endl;
+    } else if (key == "rot") {
+        rotational_latency = value;
+        std::cout << "Rotational latency set to: " << rotational_latency << " us" << std::endl;
+    } else if (key == "xfer") {
+        transfer_time = value;
+        std::cout << "Transfer time per page set to: " << transfer_time << " us" << std::endl;
+    } else if (key == "ra") {
+        readahead_max = value;
+        std::cout << "Readahead window limit set to: " << readahead_max << " pages" << std::endl;
+    } else if (key == "tlb") {
+        tlb_entries = value;
+        std::cout << "TLB entries set to: " << tlb_entries << std::endl;
+    } else if (key == "tlbways") {
+        tlb_ways = value;
+        std::cout << "TLB associativity set to: " << tlb_ways << std::endl;
+    } else if (key == "tlb2") {
+        tlb2_entries = value;
+        std::cout << "Second-level TLB entries set to: " << tlb2_entries << std::endl;
+    } else if (key == "tlb2ways") {
+        tlb2_ways = value;
+        std::cout << "Second-level TLB associativity set to: " << tlb2_ways << std::endl;
+    } else if (key == "tlbrepl") {
+        tlb_replacement = std::max(0, std::min(value, (int)TLB_RANDOM));
+        std::cout << "TLB replacement set to: " << (tlb_replacement == TLB_LRU ? "LRU" : tlb_replacement == TLB_FIFO ? "FIFO" : "random") << std::endl;
+    } else if (key == "asid") {
+        tlb_asid_tagged = value;
+        std::cout << "TLB " << (tlb_asid_tagged ? "tags entries with ASIDs" : "is flushed on process switch") << std::endl;
+    } else if (key == "tlbcyc") {
+        tlb_hit_cycles = value;
+        std::cout << "TLB hit cost set to: " << tlb_hit_cycles << " cycles" << std::endl;
+    } else if (key == "tlb2cyc") {
+        tlb2_hit_cycles = value;
+        std::cout << "Second-level TLB hit cost set to: " << tlb2_hit_cycles << " cycles" << std::endl;
+    } else if (key == "walk") {
+        page_walk_cycles = value;
+        std::cout << "Page table walk cost set to: " << page_walk_cycles << " cycles per access" << std::endl;
+    } else if (key == "lfuage") {
+        lfu_aging_interval = value;
+        std::cout << "LFU aging interval set to: " << lfu_aging_interval << " references" << std::endl;
+    } else if (key == "wsdelta") {
+        working_set_window = value;
+        std::cout << "Working set window set to: " << working_set_window << " references" << std::endl;
+    } else if (key == "pff") {
+        pff_threshold = value;
+        std::cout << "PFF threshold set to: " << pff_threshold << " references" << std::endl;
+    } else if (key == "alloc") {
+        allocation_policy = std::max(0, std::min(value, (int)allocationPolicyNames.size() - 1));
+        std::cout << "Frame allocation set to: " << allocationPolicyNames[allocation_policy] << std::endl;
+    } else if (key == "scope") {
+        replacement_scope = value;
+        std::cout << "Replacement scope set to: " << (replacement_scope ? "local" : "global") << std::endl;
+    } else if (key.compare(0, 4, "prio") == 0 && key.size() > 4 && key.size() <= 13 &&
+               key.find_first_not_of("0123456789", 4) == std::string::npos) {
+        processPriority[std::stoi(key.substr(4))] = value;
+        std::cout << "Priority of process " << key.substr(4) << " set to: " << value << std::endl;
+    } else if (key == "cpu") {
+        cpu_scheduler = value;
+        std::cout << "CPU scheduler set to: " << (value == 0 ? "sequential" : value == 1 ? "round robin" : "run until fault") << std::endl;
+    } else if (key == "quantum") {
+        cpu_quantum = std::max(value, 1);
+        std::cout << "CPU quantum set to: " << cpu_quantum << " references" << std::endl;
+    } else if (key == "reftime") {
+        reference_time = value;
+        std::cout << "Reference time set to: " << reference_time << " microseconds" << std::endl;
+    } else if (key == "pt") {
+        page_table_kind = std::max(0, std::min(value, (int)pageTableNames.size() - 1));
+        std::cout << "Page table layout set to: " << pageTableNames[page_table_kind] << std::endl;
     } else {
         std::cerr << "Unknown configuration key: " << key << std::endl;
     }
     std::cout << "Configuration: " << key << " = " << value << std::endl;
 }
 
-void handleMemoryAddress(const std::string& processIdStr, const std::string& addressStr) {
+void handleMemoryAddress(const std::string& processIdStr, const std::string& addressStr, bool write) {
     int process_id = std::stoi(processIdStr.substr(3)); // Extract numeric ID from pid1, pid2, etc.
     unsigned int address = std::stoul(addressStr, nullptr, 16); // Convert hex string to unsigned int
 
     // Add address to memoryAddresses map for the corresponding process ID
-    memoryAddresses[process_id].push_back({address});
+    memoryAddresses[process_id].append(address, write);
 }
 
 void readConfiguration(const char *filename) {
@@ -164,7 +991,12 @@ void readConfiguration(const char *filename) {
 
         iss >> key;
         if (key == "tp" || key == "ps" || key == "r" || key == "X" ||
-            key == "min" || key == "max" || key == "k" || key == "maxtrack" || key == "y") {
+            key == "min" || key == "max" || key == "k" || key == "maxtrack" || key == "y" ||
+            key == "seek" || key == "rot" || key == "xfer" || key == "ra" || key == "tlb" ||
+            key == "tlbways" || key == "tlb2" || key == "tlb2ways" || key == "tlbrepl" || key == "asid" ||
+            key == "tlbcyc" || key == "tlb2cyc" || key == "walk" || key == "pt" ||
+            key == "lfuage" || key == "wsdelta" || key == "pff" || key == "alloc" || key == "scope" ||
+            key == "cpu" || key == "quantum" || key == "reftime" || key.compare(0, 4, "prio") == 0) {
             int value;
             iss >> value;
             handleConfiguration(key, value);
@@ -172,11 +1004,13 @@ void readConfiguration(const char *filename) {
             currentProcessID = std::stoi(key.substr(3));
             if (line.find("0x") != std::string::npos)  // address
             {
-                iss >> addr;
-                handleMemoryAddress("pid" + std::to_string(currentProcessID), addr);
+                std::string access; // Optional R or W after the address, reads by default
+                iss >> addr >> access;
+                handleMemoryAddress("pid" + std::to_string(currentProcessID), addr, access == "W" || access == "w");
             } else  {
                 int size;
                 iss >> size;
+                if (size != -1) pagesPerProcess[currentProcessID] = size;
                 if (size == -1) {
                     std::cout << "End of data for process ID " << currentProcessID << std::endl;
                     continue;
@@ -200,52 +1034,59 @@ bool isValidFrameIndex(int frame_index) {
     return frame_index >= 0 && frame_index < total_frames;
 }
 
-void initializeGlobals() {
-    page_tables = std::make_unique<std::unique_ptr<PageTableEntry[]>[]>(total_processes + 1);
+// The dense layout is sized from the process's declared pages; the radix and hashed layouts map the
+// whole 32-bit address space and only allocate for pages that are touched
+void Simulation::initializePageTables() {
+    long long address_space_pages = std::min<long long>((1LL << 32) / std::max(page_size, 1), INT_MAX);
+    page_tables.resize(total_processes + 1);
     for (int i = 1; i <= total_processes; ++i) {
-        int num_pages = pagesPerProcess[i]; // Make sure pagesPerProcess is populated before this is called
-        page_tables[i] = std::make_unique<PageTableEntry[]>(num_pages);
-        for (int j = 0; j < num_pages; ++j) {
-            page_tables[i][j].frame_number = -1;
-            page_tables[i][j].disk_address = -1;
+        if (pageTableNames[page_table_kind] == "radix") {
+            page_tables[i] = std::make_unique<RadixPageTable>(i, address_space_pages);
+        } else if (pageTableNames[page_table_kind] == "hashed") {
+            page_tables[i] = std::make_unique<HashedPageTable>(i, address_space_pages);
+        } else {
+            // Runs share pagesPerProcess read-only; a process without a pages line has no pages
+            auto declared = pagesPerProcess.find(i);
+            int num_pages = declared != pagesPerProcess.end() ? declared->second : 0;
+            page_tables[i] = std::make_unique<DensePageTable>(i, num_pages);
+            for (int j = 0; j < num_pages; ++j) page_tables[i]->entry(j);
         }
     }
 }
 
-
-void initPageTables(const std::unordered_map<int, std::vector<DiskPage>>& diskPages, int total_processes) {
-    for (int process_id = 1; process_id <= total_processes; ++process_id) {
-        int num_pages = diskPages.at(process_id).size();
-        page_tables[process_id] = std::make_unique<PageTableEntry[]>(num_pages);
-        for (int page_index = 0; page_index < num_pages; ++page_index) {
-            page_tables[process_id][page_index].frame_number = -1;
-            page_tables[process_id][page_index].disk_address = diskPages.at(process_id)[page_index].trackNum;
-        }
-    }
-}
-void initializeSemaphores() {
-    if (sem_init(&disk_semaphore, 0, 1) == -1) {
+void Simulation::initializeSemaphores() {
+    if (sem_init(&disk_semaphore, 0, 1) == -1 || sem_init(&request_sem, 0, 0) == -1 ||
+        sem_init(&io_done_sem, 0, 0) == -1) {
         throw std::runtime_error("Semaphore initialization failed: " + std::string(strerror(errno)));
     }
 
 }
 
-void initFrameTable(int total_frames) {
+void Simulation::initFrameTable(int total_frames) {
     frame_table = std::make_unique<FrameTableEntry[]>(total_frames);
     for (int i = 0; i < total_frames; i++) {
         frame_table[i].process_id = -1;
         frame_table[i].page_number = -1;
         frame_table[i].forward_link = -1;
         frame_table[i].backward_link = -1;
+        frame_table[i].disk_address = -1;
+        frame_table[i].access_count = 0;
+        frame_table[i].next_use = NEVER_USED_AGAIN;
+        frame_table[i].prefetched = false;
+        frame_table[i].dirty = false;
+        frame_table[i].referenced = false;
     }
+    lru_head = lru_tail = -1;
+    free_frame_count = total_frames;
+    pending_reads.assign(total_frames, 0);
 }
 
-void populateDiskQueue() {
+void Simulation::populateDiskQueue() {
     for (const auto& entry : diskPages) {
         int process_id = entry.first;
         const std::vector<DiskPage>& pages = entry.second;
         for (const auto& page : pages) {
-            DiskQueueEntry disk_entry;
+            DiskQueueEntry disk_entry = {};
             disk_entry.process_id = process_id;
             disk_entry.operation = 'R'; // Assuming read operation for simulation
             disk_entry.disk_addr = page.trackNum; // Using trackNum as disk address
@@ -265,291 +1106,930 @@ int getDiskAddress(int process_id, int page_number) {
             return it->second[page_number].trackNum;
         }
     }
-    // If process ID or page number is invalid, return -1
+    // Pages beyond the disk table (sparse address spaces) are spread over the tracks by page number
+    if (page_number >= 0) return page_number % (max_disk_track + 1);
     return -1;
 }
 
 
-void scheduleDiskIO(DiskQueueEntry* entry) {
+void Simulation::scheduleDiskIO(DiskQueueEntry* entry) {
     if (entry == nullptr || entry->disk_addr == -1) {
-        std::cerr << "Error: Attempted to schedule disk I/O with an invalid entry." << std::endl;
+        log << "Error: Attempted to schedule disk I/O with an invalid entry." << std::endl;
         return;
     }
 
     if (!isValidFrameIndex(entry->frame_index)) {
-        std::cerr << "Error: Invalid frame index " << entry->frame_index << ". Cannot schedule disk I/O." << std::endl;
+        log << "Error: Invalid frame index " << entry->frame_index << ". Cannot schedule disk I/O." << std::endl;
         return;
     }
 
+    lockDiskQueue();
+    if (disk_queue_length > 0) waitForQueueSlot();  // A queue length of 0 leaves the disk queue unbounded
+    entry->issue_clock = cpu_clock;
+    diskQueue.push_back(*entry);
+    outstanding_requests++;
+    if (entry->operation == 'R') pending_reads[entry->frame_index]++;
+    for (int frame : entry->readahead_frames) pending_reads[frame]++;
+    issue_horizon = cpu_clock;
+    unlockDiskQueue();
+    sem_post(&request_sem);
+
+    queued_requests++;
+    events(2) << "Scheduled disk I/O for process " << entry->process_id <<
+              " on frame " << entry->frame_index <<
+              " at disk address " << entry->disk_addr << std::endl;
+}
+
+
+void Simulation::lockDiskQueue() {
     if (sem_wait(&disk_semaphore) != 0) {
         throw std::runtime_error("Failed to lock disk semaphore: " + std::string(strerror(errno)));
     }
+}
 
-    diskQueue.push_back(*entry);
-
+void Simulation::unlockDiskQueue() {
     if (sem_post(&disk_semaphore) != 0) {
         perror("Failed to unlock disk semaphore");
         exit(EXIT_FAILURE);
     }
-
-    std::cout << "Scheduled disk I/O for process " << entry->process_id <<
-              " on frame " << entry->frame_index <<
-              " at disk address " << entry->disk_addr << std::endl;
 }
 
+// Driver thread. Waits until the next request can be chosen on simulated time: every request issued
+// by disk_clock has been queued, because the replay has moved past disk_clock or is waiting on the
+// disk. Those requests join the pending pool; an idle disk jumps ahead to the next issue time.
+// Returns false once the replay is over and every request has been serviced.
+bool Simulation::admitDiskRequests() {
+    lockDiskQueue();
+    while (true) {
+        if (issue_horizon > disk_clock || awaiting_slot || !awaited_frames.empty()) {
+            while (!diskQueue.empty() && diskQueue.front().issue_clock <= disk_clock) {
+                disk_pending.splice(disk_pending.end(), diskQueue, diskQueue.begin());
+                pending_tracks.emplace(disk_pending.back().disk_addr, std::prev(disk_pending.end()));
+            }
+            if (!disk_pending.empty()) break;
+            if (!diskQueue.empty()) {
+                disk_clock = settled_clock = diskQueue.front().issue_clock;
+                sem_post(&io_done_sem);
+                continue;
+            }
+            if (driver_stopping) break;
+        }
+        unlockDiskQueue();
+        sem_wait(&request_sem);
+        lockDiskQueue();
+    }
+    unlockDiskQueue();
+    return !disk_pending.empty();
+}
 
-// Utility function to extract the page number given an address and page size
-int extractPageNumber(unsigned int address, int page_size) {
-    return address / page_size;
+// Takes a request out of the pending pool and services it. A write-back absorbs the pending writes
+// on the tracks that follow it without a gap, so they are written in one pass.
+void Simulation::servicePending(TrackIndex::iterator next, const std::string& algorithmName) {
+    DiskQueueEntry request = std::move(*next->second);
+    disk_pending.erase(next->second);
+    pending_tracks.erase(next);
+    if (request.operation == 'W') {
+        for (auto it = pending_tracks.lower_bound(request.disk_addr);
+             it != pending_tracks.end() && it->first <= request.cluster_end + 1;) {
+            const DiskQueueEntry& write = *it->second;
+            if (write.operation != 'W') {
+                ++it;
+                continue;
+            }
+            request.cluster_end = std::max(request.cluster_end, write.cluster_end);
+            request.write_pages += write.write_pages;
+            request.issue_clock = std::min(request.issue_clock, write.issue_clock);
+            disk_pending.erase(it->second);
+            it = pending_tracks.erase(it);
+        }
+    }
+    processDiskRequest(request, algorithmName);
 }
 
-void fifoDiskScheduling(const std::string& algorithmName) {
-    while (!diskQueue.empty()) {
-        processDiskRequest(diskQueue.front(), "FIFO");
-        diskQueue.pop_front();
+// Marks a serviced request done: frees its queue slots and wakes a process waiting on the disk
+void Simulation::completeDiskRequest(const DiskQueueEntry& request) {
+    int slots = request.operation == 'W' ? request.write_pages : 1;  // One slot per write merged into it
+    lockDiskQueue();
+    if (request.operation == 'R') {
+        pending_reads[request.frame_index]--;
+        read_done_at[request.frame_index] = disk_clock;
+        for (int frame : request.readahead_frames) {
+            pending_reads[frame]--;
+            read_done_at[frame] = disk_clock;
+        }
+    }
+    total_io_wait += disk_clock - request.issue_clock;
+    outstanding_requests -= slots;
+    last_completion_clock = settled_clock = disk_clock;
+    last_completion_slots = slots;
+    awaiting_slot = false;
+    if (std::any_of(awaited_frames.begin(), awaited_frames.end(), [&](int frame) { return pending_reads[frame] == 0; })) {
+        awaited_frames.clear();
     }
+    unlockDiskQueue();
+    if (request.operation == 'R') metrics.fault_service.record(disk_clock - request.issue_clock);
+    sem_post(&io_done_sem);
 }
 
-void sstfDiskScheduling(const std::string& algorithmName) {
-    auto comp = [&] (const DiskQueueEntry& a, const DiskQueueEntry& b) {
-        return abs(a.disk_addr - current_head_position) < abs(b.disk_addr - current_head_position);
-    };
-    std::set<DiskQueueEntry, decltype(comp)> sortedQueue(comp);
-    for (const auto& request : diskQueue) {
-        sortedQueue.insert(request);
+// Replay thread, disk queue locked. Lets the driver catch up with cpu_clock, so that every request
+// completing by then has completed. The driver stops at most one request past it.
+void Simulation::catchUpDisk() {
+    if (issue_horizon < cpu_clock) {
+        issue_horizon = cpu_clock;
+        sem_post(&request_sem);
     }
-    while (!sortedQueue.empty()) {
-        processDiskRequest(*sortedQueue.begin(), algorithmName);
-        sortedQueue.erase(sortedQueue.begin());
+    while (settled_clock < cpu_clock && outstanding_requests > 0) {
+        unlockDiskQueue();
+        sem_wait(&io_done_sem);
+        lockDiskQueue();
     }
 }
 
-void scanDiskScheduling(const std::string& algorithmName) {
-    // Ensure the queue is sorted for scan (ascending or descending based on head movement)
-    diskQueue.sort([](const DiskQueueEntry& a, const DiskQueueEntry& b) {
-        return a.disk_addr < b.disk_addr;
-    });
-    for (auto& request : diskQueue) {
-        processDiskRequest(request, algorithmName);
+// Replay thread, disk queue locked. Sleeps until the driver completes the request awaiting_slot or
+// awaited_frames is waiting for.
+void Simulation::waitForCompletion() {
+    issue_horizon = std::max(issue_horizon, cpu_clock);
+    sem_post(&request_sem);
+    while (awaiting_slot || !awaited_frames.empty()) {
+        unlockDiskQueue();
+        sem_wait(&io_done_sem);
+        lockDiskQueue();
     }
-    diskQueue.clear();
 }
 
-int findFreeFrame() {
-    for (int i = 0; i < total_frames; ++i) {
-        if (frame_table[i].process_id == -1) {
-            return i;
-        }
+// Replay thread, disk queue locked. A request holds its slot from being queued until it completes on
+// the simulated disk; with all y slots taken at cpu_clock, the process waits for the next completion.
+void Simulation::waitForQueueSlot() {
+    catchUpDisk();
+    bool completed_later = last_completion_clock > cpu_clock;  // Its slot is still taken at cpu_clock
+    if (outstanding_requests + (completed_later ? last_completion_slots : 0) < disk_queue_length) return;
+    if (!completed_later) {
+        awaiting_slot = true;
+        waitForCompletion();
     }
-    return -1;  // No free frame available
+    cpu_clock = std::max(cpu_clock, last_completion_clock);
 }
 
+// Holds the replaying process until the frame's read has completed, on simulated time, before it
+// uses or reuses the frame
+void Simulation::waitForDiskRead(int frame_index) {
+    lockDiskQueue();
+    if (pending_reads[frame_index] > 0) {
+        awaited_frames.assign(1, frame_index);
+        waitForCompletion();
+    }
+    long done = read_done_at[frame_index];
+    unlockDiskQueue();
+    if (done > cpu_clock) {
+        blocked_reads++;
+        blocked_time += done - cpu_clock;
+        cpu_clock = done;
+    }
+}
 
-void lfuPageReplacement(int process_id) {
-    int least_frequently_used_frame = -1;
-    int minimum_access_count = INT_MAX;
+// Utility function to extract the page number given an address and page size
+int extractPageNumber(unsigned int address, int page_size) {
+    return address / page_size;
+}
 
-    // Find the frame with the least frequency of access
-    for (int i = 0; i < total_frames; ++i) {
-        if (frame_table[i].process_id == process_id && frame_table[i].access_count < minimum_access_count) {
-            least_frequently_used_frame = i;
-            minimum_access_count = frame_table[i].access_count;
-        }
-    }
+// Each scheduler services one request from the pending pool per call; the driver admits the requests
+// issued meanwhile before the next call.
+void Simulation::fifoDiskScheduling(const std::string& algorithmName) {
+    // The oldest pending request is also the oldest on its track
+    servicePending(pending_tracks.lower_bound(disk_pending.front().disk_addr), algorithmName);
+}
 
-    if (least_frequently_used_frame != -1) {
-        // Simulate removing the page from the frame
-        frame_table[least_frequently_used_frame].process_id = -1;
-        frame_table[least_frequently_used_frame].page_number = -1;
-        frame_table[least_frequently_used_frame].access_count = 0;  // Reset the access count
+// Head movement that services no request: SCAN running on to the edge, or the C-SCAN/C-LOOK return
+void Simulation::moveHead(int track) {
+    int distance = abs(current_head_position - track);
+    total_seek_distance += distance;
+    disk_clock += (long)distance * seek_time_per_track;
+    current_head_position = track;
+}
 
-        std::cout << "LFU replacement: Replaced frame " << least_frequently_used_frame << std::endl;
-    } else {
-        std::cerr << "No suitable frame found for LFU replacement!" << std::endl;
+// Always services the pending request nearest the head, found around lower_bound in O(log n)
+void Simulation::sstfDiskScheduling(const std::string& algorithmName) {
+    TrackIndex& pending = pending_tracks;
+    auto next = pending.lower_bound(current_head_position);
+    if (next == pending.end() ||
+        (next != pending.begin() && current_head_position - std::prev(next)->first < next->first - current_head_position)) {
+        next = pending.lower_bound(std::prev(next)->first);  // Oldest request on the closer track below
     }
+    servicePending(next, algorithmName);
 }
 
-void lifoPageReplacement(int process_id) {
-    static std::vector<int> lifoStack; // Vector to simulate stack behavior for LIFO
-
-    if (!lifoStack.empty()) {
-        int freed_frame_index = lifoStack.back();
-        lifoStack.pop_back();
+// Elevator family. The head services requests in head_direction until none are left ahead of it;
+// to_edge runs on to the last track first (SCAN, C-SCAN) rather than turning at the last request
+// (LOOK, C-LOOK), and circular jumps back to the far end instead of reversing.
+void Simulation::sweepDiskScheduling(const std::string& algorithmName, bool to_edge, bool circular) {
+    TrackIndex& pending = pending_tracks;
+    while (true) {
+        int last_track = std::max(max_disk_track, pending.rbegin()->first);
+        if (head_direction > 0) {
+            auto next = pending.lower_bound(current_head_position);
+            if (next != pending.end()) {
+                servicePending(next, algorithmName);
+                return;
+            }
+        } else {
+            auto next = pending.upper_bound(current_head_position);
+            if (next != pending.begin()) {
+                servicePending(pending.lower_bound(std::prev(next)->first), algorithmName);
+                return;
+            }
+        }
 
-        // Invalidate the page in the page table and frame table
-        for (int page_number = 0; page_number < pagesPerProcess[process_id]; ++page_number) {
-            if (page_tables[process_id][page_number].frame_number == freed_frame_index) {
-                page_tables[process_id][page_number].frame_number = -1; // Invalidate
-                frame_table[freed_frame_index] = {-1, -1, -1, -1, -1, 0}; // Clear the frame
-                break; // Exit after invalidating the page
+        // Nothing left ahead of the head
+        int edge = head_direction > 0 ? last_track : 0;
+        if (circular) {
+            if (to_edge) {
+                moveHead(edge);
+                moveHead(last_track - edge);
+            } else {
+                moveHead(head_direction > 0 ? pending.begin()->first : pending.rbegin()->first);
             }
+        } else {
+            if (to_edge) moveHead(edge);
+            head_direction = -head_direction;
         }
-        std::cout << "LIFO replacement: Replaced frame at index " << freed_frame_index << std::endl;
     }
+}
 
-    // Note: The function does not return a value anymore
+void Simulation::scanDiskScheduling(const std::string& algorithmName) {
+    sweepDiskScheduling(algorithmName, true, false);
 }
 
-void lruPageReplacement(int process_id) {
-    static std::list<int> lruList; // List to track the least recently used frames
+void Simulation::cscanDiskScheduling(const std::string& algorithmName) {
+    sweepDiskScheduling(algorithmName, true, true);
+}
 
-    if (!lruList.empty()) {
-        int freed_frame_index = lruList.front();
-        lruList.pop_front();
+void Simulation::lookDiskScheduling(const std::string& algorithmName) {
+    sweepDiskScheduling(algorithmName, false, false);
+}
 
-        // Invalidate the page in the page table and frame table
-        for (int page_number = 0; page_number < pagesPerProcess[process_id]; ++page_number) {
-            if (page_tables[process_id][page_number].frame_number == freed_frame_index) {
-                page_tables[process_id][page_number].frame_number = -1; // Invalidate
-                frame_table[freed_frame_index] = {-1, -1, -1, -1, -1, 0}; // Clear the frame
-                break; // Exit after invalidating the page
-            }
+void Simulation::clookDiskScheduling(const std::string& algorithmName) {
+    sweepDiskScheduling(algorithmName, false, true);
+}
+
+int Simulation::findFreeFrame() {
+    if (free_frame_count == 0) return -1;
+    for (int i = 0; i < total_frames; ++i) {
+        if (frame_table[i].process_id == -1) {
+            return i;
         }
-        std::cout << "LRU replacement: Replaced frame " << freed_frame_index << std::endl;
     }
-
-    // Note: The function does not return a value anymore
+    return -1;  // No free frame available
 }
 
 
-void mruPageReplacement(int process_id) {
-    static int most_recently_used_frame = -1;  // Static variable declaration
-    std::cout << "Running MRU Page Replacement for process ID " << process_id << std::endl;
-
-    if (!isValidFrameIndex(most_recently_used_frame)) {
-        std::cerr << "Invalid MRU frame index: " << most_recently_used_frame << std::endl;
-        most_recently_used_frame = findFreeFrame();  // Attempt to recover by finding a new frame
-    }
+// The LRU list links frames through forward_link (towards the most recent) and backward_link
+// (towards the least recent), so touching and evicting never allocate.
+void Simulation::lruUnlink(int frame_index) {
+    FrameTableEntry& frame = frame_table[frame_index];
+    if (frame.backward_link != -1) frame_table[frame.backward_link].forward_link = frame.forward_link;
+    else if (lru_head == frame_index) lru_head = frame.forward_link;
+    if (frame.forward_link != -1) frame_table[frame.forward_link].backward_link = frame.backward_link;
+    else if (lru_tail == frame_index) lru_tail = frame.backward_link;
+    frame.forward_link = -1;
+    frame.backward_link = -1;
+}
 
-    // Reset the old MRU frame
-    if (isValidFrameIndex(most_recently_used_frame)) {
-        frame_table[most_recently_used_frame].process_id = -1;
-        frame_table[most_recently_used_frame].page_number = -1;
-        std::cout << "Cleared old MRU frame: " << most_recently_used_frame << std::endl;
-    }
+void Simulation::lruPushMostRecent(int frame_index) {
+    FrameTableEntry& frame = frame_table[frame_index];
+    frame.backward_link = lru_tail;
+    frame.forward_link = -1;
+    if (lru_tail != -1) frame_table[lru_tail].forward_link = frame_index;
+    lru_tail = frame_index;
+    if (lru_head == -1) lru_head = frame_index;
+}
 
-    // Set new MRU frame
-    most_recently_used_frame = findFreeFrame();
-    if (isValidFrameIndex(most_recently_used_frame)) {
-        frame_table[most_recently_used_frame].process_id = process_id;
-        std::cout << "New MRU frame assigned: " << most_recently_used_frame << std::endl;
-    } else {
-        std::cerr << "Failed to find valid frame for MRU" << std::endl;
-    }
+// Moves a referenced frame to the most recently used end
+void Simulation::lruTouch(int frame_index) {
+    if (frame_index == lru_tail) return;
+    lruUnlink(frame_index);
+    lruPushMostRecent(frame_index);
 }
 
-void workingSetPageReplacement(int process_id, int delta) {
-    auto current_time_point = std::chrono::steady_clock::now();
-    std::unordered_map<int, std::chrono::steady_clock::time_point> last_used;
+// Loads a page into a free frame and makes it the most recently used
+void Simulation::installPage(int frame_index, int process_id, int page_number) {
+    frame_table[frame_index].process_id = process_id;
+    frame_table[frame_index].page_number = page_number;
+    PageTableEntry& entry = page_tables[process_id]->entry(page_number);
+    frame_table[frame_index].disk_address = entry.disk_address;
+    frame_table[frame_index].access_count = 1;
+    entry.frame_number = frame_index;
+    lruPushMostRecent(frame_index);
+    free_frame_count--;
+    resident_frames[process_id]++;
+    frame_last_reference[frame_index] = current_reference;
+    if (tracks_load_order) lifoStack.push_back(frame_index);
+    policyInstall(frame_index);
+}
 
-    // Update last_used based on access history within the delta time frame
-    for (int i = std::max(0, (int)accessHistory[process_id].size() - delta); i < accessHistory[process_id].size(); ++i) {
-        last_used[accessHistory[process_id][i]] = current_time_point;
+// Frees a frame: invalidates the owner's page table entry and takes it off the recency list.
+// Every replacement policy evicts through here so the page tables and the LRU list stay consistent.
+void Simulation::evictFrame(int frame_index) {
+    waitForDiskRead(frame_index);  // The frame cannot be reused while its page is still being read
+    FrameTableEntry& frame = frame_table[frame_index];
+    if (frame.process_id != -1 && frame.page_number >= 0) {
+        PageTableEntry* entry = page_tables[frame.process_id]->find(frame.page_number);
+        if (entry != nullptr && entry->frame_number == frame_index) entry->frame_number = -1;
     }
-
-    int current_working_set_size = last_used.size();
-    auto& ws_sizes = working_set_sizes[process_id];
-    ws_sizes.first = std::min(ws_sizes.first, current_working_set_size);
-    ws_sizes.second = std::max(ws_sizes.second, current_working_set_size);
-
-    int least_recently_used_frame = -1;
-    std::chrono::steady_clock::time_point oldest_time = current_time_point;
-
-    // Identify the least recently used frame
-    for (const auto& page : last_used) {
-        if (page.second < oldest_time) {
-            oldest_time = page.second;
-            least_recently_used_frame = page_tables[process_id][page.first].frame_number;
+    lruUnlink(frame_index);
+    if (!optQueue.empty()) optQueue.erase({frame.next_use, frame_index});
+    if (frame.process_id != -1) {
+        free_frame_count++;
+        resident_frames[frame.process_id]--;
+        metrics.evictions++;
+        if (tlb.enabled()) {  // Shootdown: no TLB may keep translating to the freed frame
+            tlb.invalidate(frame.process_id, frame.page_number);
+            if (tlb2.enabled()) tlb2.invalidate(frame.process_id, frame.page_number);
         }
     }
-
-    if (least_recently_used_frame != -1) {
-        frame_table[least_recently_used_frame].process_id = -1;
-        frame_table[least_recently_used_frame].page_number = -1;
-        std::cout << "Working Set replacement: Replaced frame " << least_recently_used_frame << std::endl;
-    } else {
-        std::cerr << "No suitable frame found for Working Set replacement!" << std::endl;
+    if (frame.prefetched) {  // Read ahead for nothing: shrink that process's window
+        readahead_wasted++;
+        ReadaheadState& state = readahead_state[frame.process_id];
+        state.window /= 2;
     }
+    if (frame.dirty && frame.process_id != -1 && frame.disk_address != -1) requestWriteBack(frame_index);
+    policyForget(frame_index);
+    frame = {-1, -1, -1, -1, -1, 0, NEVER_USED_AGAIN, false, false, false};
 }
 
+bool Simulation::evictable(int frame_index) {
+    int owner = frame_table[frame_index].process_id;
+    if (replacement_owner != -1) return owner == replacement_owner;
+    if (victims_over_quota) return owner != -1 && resident_frames[owner] > frame_quota[owner];
+    return true;
+}
 
-void optLookaheadPageReplacement(int process_id, int lookahead) {
-    int longest_future_use_index = -1;
-    int max_future_time = -1;
-
-    // Simulate "future knowledge" by selecting the page least likely to be used soon
-    for (int i = 0; i < total_frames; ++i) {
-        if (frame_table[i].process_id == process_id) {
-            int future_use_time = lookahead + (rand() % 100);  // Random future usage time for demonstration
-            if (future_use_time > max_future_time) {
-                max_future_time = future_use_time;
-                longest_future_use_index = i;
+// Runs the replacement policy once; false when it found nothing to evict. With a frame allocation,
+// a process at its quota under local scope replaces one of its own pages; every other reclaim takes
+// from processes above their quota first and from anyone only when none is. A process_id of -1 is
+// the page daemon, which never acts for one process.
+bool Simulation::reclaimFrame(int process_id) {
+    int free_before = free_frame_count;
+    if (allocation_policy > 0) {
+        if (replacement_scope == 1 && process_id != -1 && resident_frames[process_id] > 0 &&
+            resident_frames[process_id] >= frame_quota[process_id]) {
+            replacement_owner = process_id;
+        } else {
+            for (const auto& resident : resident_frames) {
+                if (resident.second > frame_quota[resident.first]) victims_over_quota = true;
             }
         }
     }
+    (this->*pageReplacementAlgorithms[page_algorithm])(process_id);
+    replacement_owner = -1;
+    victims_over_quota = false;
+    return free_frame_count > free_before;
+}
 
-    if (longest_future_use_index != -1) {
-        // Replace the page
-        frame_table[longest_future_use_index].process_id = -1;
-        frame_table[longest_future_use_index].page_number = -1;
-        std::cout << "OPT replacement: Replaced frame " << longest_future_use_index << std::endl;
+// Page daemon: once the free pool drops below min it evicts a batch, through the run's replacement
+// policy, until max frames are free again, so the following faults find a frame without reclaiming.
+// A min of 0 disables the pool and replacement happens only on the fault path.
+void Simulation::refillFreePool(int /*process_id*/) {
+    if (min_free_pool_size <= 0 || free_frame_count >= min_free_pool_size) return;
+    int target = std::min(std::max(max_free_pool_size, min_free_pool_size), total_frames);
+    daemon_runs++;
+    while (free_frame_count < target && reclaimFrame(-1)) {
+        daemon_evictions++;
     }
 }
 
-void lruXPageReplacement(int process_id, int X) {
-    int lru_frame = -1;
-    int oldest_access_time = INT_MAX;
-
-    // Iterate through all frames to find the least recently used frame considering the X most recent accesses
-    for (int i = 0; i < total_frames; ++i) {
-        if (frame_table[i].process_id == process_id) {
-            if (accessHistory[i].size() == X && accessHistory[i].front() < oldest_access_time) {
-                oldest_access_time = accessHistory[i].front();
-                lru_frame = i;
+// Evicts the oldest frame of the lowest-frequency bucket in O(1)
+void Simulation::lfuPageReplacement(int /*process_id*/) {
+    int least_frequently_used_frame = -1;
+    for (auto bucket = lfu_buckets.begin(); bucket != lfu_buckets.end() && least_frequently_used_frame == -1; ++bucket) {
+        for (int frame_index : bucket->frames) {
+            if (evictable(frame_index)) {
+                least_frequently_used_frame = frame_index;
+                break;
             }
         }
     }
-
-    if (lru_frame != -1) {
-        // Remove the least recently used frame
-        frame_table[lru_frame].process_id = -1;
-        frame_table[lru_frame].page_number = -1;
-        accessHistory.erase(lru_frame);  // Clear the history as the frame is now free
-        std::cout << "LRU-X replacement: Replaced frame " << lru_frame << std::endl;
-    } else {
-        std::cerr << "No suitable frame found to replace!" << std::endl;
+    if (least_frequently_used_frame == -1) {
+        events(1) << "No suitable frame found for LFU replacement!" << std::endl;
+        return;
     }
+    evictFrame(least_frequently_used_frame);
+    events(1) << "LFU replacement: Replaced frame " << least_frequently_used_frame << std::endl;
 }
 
+// A loaded page starts in the frequency-1 bucket, which is always the first one if it exists
+void Simulation::lfuInsert(int frame_index) {
+    if (lfu_buckets.empty() || lfu_buckets.front().frequency != 1) lfu_buckets.push_front({1, {}});
+    auto bucket = lfu_buckets.begin();
+    bucket->frames.push_back(frame_index);
+    lfu_bucket[frame_index] = bucket;
+    lfu_position[frame_index] = std::prev(bucket->frames.end());
+    lfu_queued[frame_index] = 1;
+    frame_table[frame_index].access_count = 1;
+}
 
+// Moves a referenced frame to the next bucket up, creating it if the next frequency has no frames
+void Simulation::lfuTouch(int frame_index) {
+    auto bucket = lfu_bucket[frame_index];
+    auto next = std::next(bucket);
+    if (next == lfu_buckets.end() || next->frequency != bucket->frequency + 1) {
+        next = lfu_buckets.insert(next, {bucket->frequency + 1, {}});
+    }
+    next->frames.splice(next->frames.end(), bucket->frames, lfu_position[frame_index]);
+    lfu_bucket[frame_index] = next;
+    frame_table[frame_index].access_count = next->frequency;
+    if (bucket->frames.empty()) lfu_buckets.erase(bucket);
 
+    if (lfu_aging_interval > 0 && ++lfu_references % lfu_aging_interval == 0) lfuAge();
+}
 
+void Simulation::lfuRemove(int frame_index) {
+    if (!lfu_queued[frame_index]) return;
+    auto bucket = lfu_bucket[frame_index];
+    bucket->frames.erase(lfu_position[frame_index]);
+    if (bucket->frames.empty()) lfu_buckets.erase(bucket);
+    lfu_queued[frame_index] = 0;
+}
 
+// Halves every count so pages that were hot long ago can be evicted. Halving keeps the buckets in
+// order, and buckets that now share a frequency are spliced together.
+void Simulation::lfuAge() {
+    for (auto bucket = lfu_buckets.begin(); bucket != lfu_buckets.end();) {
+        bucket->frequency = std::max(1, bucket->frequency / 2);
+        for (int frame_index : bucket->frames) frame_table[frame_index].access_count = bucket->frequency;
+        if (bucket != lfu_buckets.begin() && std::prev(bucket)->frequency == bucket->frequency) {
+            auto merged = std::prev(bucket);
+            for (int frame_index : bucket->frames) lfu_bucket[frame_index] = merged;
+            merged->frames.splice(merged->frames.end(), bucket->frames);
+            bucket = lfu_buckets.erase(bucket);
+        } else {
+            ++bucket;
+        }
+    }
+}
 
+// Evicts the most recently loaded page. Frames freed since they were pushed are skipped.
+void Simulation::lifoPageReplacement(int /*process_id*/) {
+    for (int i = (int)lifoStack.size() - 1; i >= 0; i--) {
+        int freed_frame_index = lifoStack[i];
+        if (frame_table[freed_frame_index].process_id != -1 && !evictable(freed_frame_index)) continue;
+        lifoStack.erase(lifoStack.begin() + i);
+        if (frame_table[freed_frame_index].process_id == -1) continue;
 
-void diskDriverProcess() {
-    std::cout << "Running FIFO Disk Scheduling\n";
-    populateDiskQueue();
-    fifoDiskScheduling("FIFO + Default");  // Assuming 'Default' as a placeholder
-    std::cout << "Running SSTF Disk Scheduling\n";
-    populateDiskQueue();
-    sstfDiskScheduling("SSTF + Default");
-    std::cout << "Running SCAN Disk Scheduling\n";
-    populateDiskQueue();
-    scanDiskScheduling("SCAN + Default");
+        // Invalidate the page in the page table and frame table
+        evictFrame(freed_frame_index);
+        events(1) << "LIFO replacement: Replaced frame at index " << freed_frame_index << std::endl;
+        return;
+    }
 }
 
-int calculateSeekTime(int disk_addr) {
-    // Assuming a linear seek time calculation, where each track transition costs 1 time unit
-    int seek_time = abs(current_head_position - disk_addr) * 100; // Adjust scale to microseconds
-    current_head_position = disk_addr; // Update the head position
-    return seek_time; // Now returns microseconds
+// Evicts the least recently used frame, the head of the recency list, in O(1) when any frame may go
+void Simulation::lruPageReplacement(int /*process_id*/) {
+    int freed_frame_index = lru_head;
+    while (freed_frame_index != -1 && !evictable(freed_frame_index)) freed_frame_index = frame_table[freed_frame_index].forward_link;
+    if (freed_frame_index != -1) {
+
+        // Invalidate the page in the page table and frame table
+        evictFrame(freed_frame_index);
+        events(1) << "LRU replacement: Replaced frame " << freed_frame_index << std::endl;
+    }
 }
 
-void requestPageFromDisk(int frame_index, int disk_addr, int process_id) {
-    if (frame_index < 0 || frame_index >= total_frames) {
-        std::cerr << "Invalid frame index: " << frame_index << ". Cannot schedule disk I/O." << std::endl;
-        return;  // Prevent disk operations with invalid frames
+
+// Evicts the most recently used frame, the tail of the recency list, in O(1)
+void Simulation::mruPageReplacement(int /*process_id*/) {
+    int freed_frame_index = lru_tail;
+    while (freed_frame_index != -1 && !evictable(freed_frame_index)) freed_frame_index = frame_table[freed_frame_index].backward_link;
+    if (freed_frame_index != -1) {
+        evictFrame(freed_frame_index);
+        events(1) << "MRU replacement: Replaced frame " << freed_frame_index << std::endl;
+    }
+}
+
+// Evicts the page that left its process's working set longest ago. When every resident page is in
+// some working set, memory is overcommitted and the least recently used page goes instead.
+void Simulation::workingSetPageReplacement(int /*process_id*/) {
+    auto may_evict = [this](int frame_index) { return evictable(frame_index); };
+    const int* outside = ws_outside.find_first(may_evict);
+    int victim = outside != nullptr ? *outside : lru_head;
+    while (outside == nullptr && victim != -1 && !evictable(victim)) victim = frame_table[victim].forward_link;
+    if (victim == -1) {
+        events(1) << "No suitable frame found for Working Set replacement!" << std::endl;
+        return;
+    }
+    evictFrame(victim);
+    events(1) << "Working Set replacement: Replaced frame " << victim << std::endl;
+}
+
+// Slides the process's window over one reference. A page whose last occurrence drops out of the
+// window leaves the working set and, if resident, becomes a replacement candidate.
+void Simulation::workingSetReference(int process_id, int page_number) {
+    auto window = working_sets.find(process_id);
+    if (window == working_sets.end()) {
+        window = working_sets.emplace(process_id, WorkingSetWindow(working_set_window)).first;
+        working_set_sizes[process_id] = {INT_MAX, 0};
+    }
+    int departed = window->second.push(page_number);
+    if (departed != -1) {
+        PageTableEntry* entry = page_tables[process_id]->find(departed);
+        // A page read ahead again while its old references were still in the window is already outside
+        if (entry != nullptr && entry->frame_number != -1 && !ws_outside.contains(entry->frame_number)) {
+            ws_outside.push_back(entry->frame_number);
+        }
+    }
+    if (window->second.full()) {
+        auto& ws_sizes = working_set_sizes[process_id];
+        ws_sizes.first = std::min(ws_sizes.first, window->second.size());
+        ws_sizes.second = std::max(ws_sizes.second, window->second.size());
+    }
+}
+
+// A process that has finished has no working set: all its resident pages become candidates, least
+// recently used first
+void Simulation::workingSetRetire(int process_id) {
+    auto window = working_sets.find(process_id);
+    if (window == working_sets.end()) return;
+    auto& ws_sizes = working_set_sizes[process_id];
+    if (ws_sizes.first == INT_MAX) ws_sizes = {window->second.size(), window->second.size()};  // Trace shorter than delta
+    for (int frame_index = lru_head; frame_index != -1; frame_index = frame_table[frame_index].forward_link) {
+        if (frame_table[frame_index].process_id == process_id && !ws_outside.contains(frame_index)) {
+            ws_outside.push_back(frame_index);
+        }
+    }
+}
+
+// Page-fault-frequency allocation. A fault that follows the previous one within pff references means
+// the process needs more memory, and it simply keeps the frame it faults into. A longer gap means its
+// allocation is larger than its locality: every frame it has not referenced since the previous fault
+// is released first. Releasing scans the frame table, but only on these infrequent faults.
+void Simulation::pffFault(int process_id) {
+    PffState& state = pff_state[process_id];
+    if (current_reference - state.last_fault <= pff_threshold) {
+        state.grows++;
+    } else {
+        state.shrinks++;
+        for (int frame_index = 0; frame_index < total_frames; frame_index++) {
+            if (frame_table[frame_index].process_id == process_id && frame_last_reference[frame_index] < state.last_fault) {
+                evictFrame(frame_index);
+                state.released++;
+            }
+        }
+    }
+    state.last_fault = current_reference;
+}
+
+// Splits the tp frames between the processes: r each, in proportion to their declared sizes, or in
+// proportion to size times priority. Every process gets at least one frame.
+void computeFrameQuotas() {
+    if (allocation_policy == 0) return;
+    long total_weight = 0;
+    std::map<int, long> weight;
+    for (int process_id = 1; process_id <= total_processes; process_id++) {
+        auto priority = processPriority.find(process_id);
+        weight[process_id] = std::max(pagesPerProcess[process_id], 1);
+        if (allocation_policy == 3 && priority != processPriority.end()) weight[process_id] *= std::max(priority->second, 1);
+        total_weight += weight[process_id];
+    }
+    for (int process_id = 1; process_id <= total_processes; process_id++) {
+        int quota = frames_per_process;
+        if (allocation_policy != 1) quota = (int)(weight[process_id] * total_frames / std::max(total_weight, 1L));
+        frameQuota[process_id] = std::max(quota, 1);
+        std::cout << "Process " << process_id << " is allocated " << frameQuota[process_id] << " frames" << std::endl;
+    }
+}
+
+// One backward pass per process: for every reference, the position of the next reference to the
+// same page (NEVER_USED_AGAIN if there is none), plus the first reference to every page.
+// Also creates the shared map entries of every process, so the simulation threads only look them up
+void buildNextUseIndex() {
+    for (int process_id = 1; process_id <= total_processes; process_id++) {
+        const AddressTrace& addresses = memoryAddresses[process_id];
+        std::vector<int>& next = nextUse[process_id];
+        std::unordered_map<int, int>& first = firstUse[process_id];
+        first.clear();
+        next.assign(addresses.size(), NEVER_USED_AGAIN);
+        std::unordered_map<int, int> latest; // Latest position of each page seen so far
+        TraceCursor cursor(addresses);
+        for (int i = 0; i < (int)addresses.size(); ++i) {
+            int page_number = extractPageNumber(cursor.next(), page_size);
+            auto seen = latest.find(page_number);
+            if (seen == latest.end()) {
+                first[page_number] = i;
+                latest.emplace(page_number, i);
+            } else {
+                next[seen->second] = i;
+                seen->second = i;
+            }
+        }
+    }
+}
+
+// Re-keys a resident frame with the position of its page's next reference
+void Simulation::optSetNextUse(int frame_index, int next_use) {
+    FrameTableEntry& frame = frame_table[frame_index];
+    optQueue.erase({frame.next_use, frame_index});
+    frame.next_use = next_use;
+    optQueue.insert({next_use, frame_index});
+}
+
+// Rebuilds the OPT queue when a process starts replaying. Frames of other processes were either left
+// with NEVER_USED_AGAIN by their own replay or are not referenced by this one; frames this process
+// already holds are keyed by the first reference to their page.
+void Simulation::optResetQueue(int process_id) {
+    optQueue.clear();
+    const std::unordered_map<int, int>& first = firstUse[process_id];
+    for (int i = 0; i < total_frames; ++i) {
+        FrameTableEntry& frame = frame_table[i];
+        if (frame.process_id == -1) continue;
+        auto it = frame.process_id == process_id ? first.find(frame.page_number) : first.end();
+        frame.next_use = it != first.end() ? it->second : NEVER_USED_AGAIN;
+        optQueue.insert({frame.next_use, i});
+    }
+}
+
+// Belady's optimal policy: evict the resident page whose next reference is furthest away, O(log n)
+void Simulation::optPageReplacement(int /*process_id*/) {
+    auto candidate = optQueue.rbegin();
+    while (candidate != optQueue.rend() && !evictable(candidate->second)) ++candidate;
+    if (candidate == optQueue.rend()) return;
+    int victim = candidate->second;
+    evictFrame(victim);
+    events(1) << "OPT replacement: Replaced frame " << victim << std::endl;
+}
+
+// Bounded lookahead variant: only the next `lookahead` references are known. Any page not referenced
+// within the window is a candidate and the least recently used of those is evicted; if every
+// resident page is referenced within the window, the one referenced last is evicted as in OPT.
+void Simulation::optLookaheadPageReplacement(int /*process_id*/, int lookahead) {
+    long window_end = (long)current_reference + lookahead;
+    int victim = -1;
+    for (int i = lru_head; i != -1; i = frame_table[i].forward_link) {
+        if (frame_table[i].next_use > window_end && evictable(i)) {
+            victim = i;
+            break;
+        }
+    }
+    for (auto candidate = optQueue.rbegin(); victim == -1 && candidate != optQueue.rend(); ++candidate) {
+        if (evictable(candidate->second)) victim = candidate->second;
+    }
+
+    if (victim != -1) {
+        evictFrame(victim);
+        events(1) << "OPT-X replacement: Replaced frame " << victim << std::endl;
+    }
+}
+
+void Simulation::lruXPageReplacement(int process_id, int X) {
+    int lru_frame = -1;
+    int oldest_access_time = INT_MAX;
+
+    // Iterate through all frames to find the least recently used frame considering the X most recent accesses
+    for (int i = 0; i < total_frames; ++i) {
+        if (frame_table[i].process_id == process_id) {
+            if (accessHistory[i].size() == X && accessHistory[i].front() < oldest_access_time) {
+                oldest_access_time = accessHistory[i].front();
+                lru_frame = i;
+            }
+        }
+    }
+
+    if (lru_frame != -1) {
+        // Remove the least recently used frame
+        evictFrame(lru_frame);
+        accessHistory.erase(lru_frame);  // Clear the history as the frame is now free
+        events(1) << "LRU-X replacement: Replaced frame " << lru_frame << std::endl;
+    } else {
+        events(1) << "No suitable frame found to replace!" << std::endl;
+    }
+}
+
+
+
+
+
+
+
+// Queues a newly loaded frame for the CLOCK-Pro, 2Q or ARC run; ghost hits are recognised here
+void Simulation::policyInstall(int frame_index) {
+    FrameTableEntry& frame = frame_table[frame_index];
+    uint64_t key = pageKey(frame.process_id, frame.page_number);
+    frame.referenced = false;
+    if (tracks_working_set && !working_sets[frame.process_id].contains(frame.page_number)) {
+        ws_outside.push_back(frame_index);  // Read ahead, not referenced yet
+    }
+    if (policy_name == "LFU") {
+        lfuInsert(frame_index);
+    } else if (policy_name == "CLOCK-Pro") {
+        if (clock_pro_ghosts.erase(key)) {
+            // Re-referenced within its test period: cold pages deserve more room, and it comes back hot
+            cold_target = std::min(cold_target + 1, std::max(total_frames - 1, 1));
+            clock_pro_hot.push_back(frame_index);
+            if ((int)clock_pro_hot.size() > total_frames - cold_target) clockProRunHotHand();
+        } else {
+            clock_pro_cold.push_back(frame_index);
+            clock_pro_in_test[frame_index] = 1;
+        }
+    } else if (policy_name == "2Q") {
+        if (two_queue_out.erase(key)) two_queue_main.push_back(frame_index);
+        else two_queue_in.push_back(frame_index);
+    } else if (policy_name == "ARC") {
+        int c = total_frames;
+        if (arc_b1.erase(key)) {
+            arc_target = std::min<double>(c, arc_target + std::max(1.0, (double)arc_b2.size() / std::max<size_t>(arc_b1.size(), 1)));
+            arc_t2.push_back(frame_index);
+        } else if (arc_b2.erase(key)) {
+            arc_target = std::max(0.0, arc_target - std::max(1.0, (double)arc_b1.size() / std::max<size_t>(arc_b2.size(), 1)));
+            arc_t2.push_back(frame_index);
+        } else {
+            arc_t1.push_back(frame_index);
+        }
+        // Directory bounds: |T1| + |B1| <= c and |T1| + |T2| + |B1| + |B2| <= 2c
+        while (arc_t1.size() + arc_b1.size() > (size_t)c && !arc_b1.empty()) arc_b1.pop_front();
+        while (arc_t1.size() + arc_t2.size() + arc_b1.size() + arc_b2.size() > 2 * (size_t)c && !arc_b2.empty()) arc_b2.pop_front();
+    }
+}
+
+// Drops an evicted frame from whichever policy queue holds it
+void Simulation::policyForget(int frame_index) {
+    ws_outside.erase(frame_index);
+    if (policy_name == "LFU") {
+        lfuRemove(frame_index);
+    } else if (policy_name == "CLOCK-Pro") {
+        clock_pro_hot.erase(frame_index);
+        clock_pro_cold.erase(frame_index);
+        clock_pro_in_test[frame_index] = 0;
+    } else if (policy_name == "2Q") {
+        two_queue_in.erase(frame_index);
+        two_queue_main.erase(frame_index);
+    } else if (policy_name == "ARC") {
+        arc_t1.erase(frame_index);
+        arc_t2.erase(frame_index);
+    }
+}
+
+// Second chance: the hand clears reference bits until it reaches an unreferenced resident frame
+void Simulation::clockPageReplacement(int /*process_id*/) {
+    if (free_frame_count == total_frames) return;
+    while (true) {
+        FrameTableEntry& frame = frame_table[clock_hand];
+        int candidate = clock_hand;
+        clock_hand = (clock_hand + 1) % total_frames;
+        if (frame.process_id == -1 || !evictable(candidate)) continue;
+        if (frame.referenced) {
+            frame.referenced = false;
+            continue;
+        }
+        evictFrame(candidate);
+        events(1) << "CLOCK replacement: Replaced frame " << candidate << std::endl;
+        return;
+    }
+}
+
+// CLOCK-Pro hot hand: turns the first unreferenced hot page cold, and ends the test period of the
+// oldest non-resident page, which means cold pages were given more room than they used
+void Simulation::clockProRunHotHand() {
+    while (!clock_pro_hot.empty()) {
+        int frame_index = clock_pro_hot.pop_front();
+        if (frame_table[frame_index].referenced) {
+            frame_table[frame_index].referenced = false;
+            clock_pro_hot.push_back(frame_index);
+            continue;
+        }
+        clock_pro_cold.push_back(frame_index);
+        clock_pro_in_test[frame_index] = 0;
+        break;
+    }
+    if (!clock_pro_ghosts.empty()) {
+        clock_pro_ghosts.pop_front();
+        cold_target = std::max(cold_target - 1, 1);
+    }
+}
+
+// CLOCK-Pro cold hand: a referenced cold page in its test period is promoted to hot, one outside it
+// starts a new test period; the first unreferenced cold page is evicted and, if still in test,
+// remembered as a non-resident page so a quick re-reference is recognised
+void Simulation::clockProPageReplacement(int /*process_id*/) {
+    size_t passed = 0; // Cold pages the hand went past because they may not be evicted
+    while (!clock_pro_cold.empty() || !clock_pro_hot.empty()) {
+        if (clock_pro_cold.empty() || passed >= clock_pro_cold.size()) {
+            clockProRunHotHand();
+            passed = 0;
+            continue;
+        }
+        int frame_index = clock_pro_cold.pop_front();
+        FrameTableEntry& frame = frame_table[frame_index];
+        if (!evictable(frame_index)) {
+            clock_pro_cold.push_back(frame_index);
+            passed++;
+            continue;
+        }
+        passed = 0;
+        if (frame.referenced) {
+            frame.referenced = false;
+            if (clock_pro_in_test[frame_index]) {
+                clock_pro_in_test[frame_index] = 0;
+                clock_pro_hot.push_back(frame_index);
+                if ((int)clock_pro_hot.size() > total_frames - cold_target) clockProRunHotHand();
+            } else {
+                clock_pro_in_test[frame_index] = 1;
+                clock_pro_cold.push_back(frame_index);
+            }
+            continue;
+        }
+        if (clock_pro_in_test[frame_index]) {
+            clock_pro_ghosts.push_back(pageKey(frame.process_id, frame.page_number));
+            while ((int)clock_pro_ghosts.size() > total_frames) clock_pro_ghosts.pop_front();
+        }
+        evictFrame(frame_index);
+        events(1) << "CLOCK-Pro replacement: Replaced frame " << frame_index << std::endl;
+        return;
+    }
+}
+
+// 2Q: pages seen once wait in A1in (a quarter of memory) and are evicted from it first, leaving a
+// ghost in A1out (half of memory); a miss on a ghost goes to Am, which is managed as LRU
+void Simulation::twoQueuePageReplacement(int /*process_id*/) {
+    size_t in_limit = std::max(1, total_frames / 4);
+    size_t out_limit = std::max(1, total_frames / 2);
+    auto may_evict = [this](int frame_index) { return evictable(frame_index); };
+    const int* in_victim = two_queue_in.find_first(may_evict);
+    const int* main_victim = two_queue_main.find_first(may_evict);
+    int victim;
+    if (in_victim != nullptr && (two_queue_in.size() > in_limit || main_victim == nullptr)) {
+        victim = *in_victim;
+        two_queue_out.push_back(pageKey(frame_table[victim].process_id, frame_table[victim].page_number));
+        while (two_queue_out.size() > out_limit) two_queue_out.pop_front();
+    } else if (main_victim != nullptr) {
+        victim = *main_victim;
+    } else {
+        return;
+    }
+    evictFrame(victim);
+    events(1) << "2Q replacement: Replaced frame " << victim << std::endl;
+}
+
+// ARC's REPLACE: evict from T1 while it exceeds its adaptive target, otherwise from T2, and
+// remember the page in the matching ghost list
+void Simulation::arcPageReplacement(int /*process_id*/) {
+    bool faulting_in_b2 = arc_b2.contains(faulting_key);
+    auto may_evict = [this](int frame_index) { return evictable(frame_index); };
+    const int* t1_victim = arc_t1.find_first(may_evict);
+    const int* t2_victim = arc_t2.find_first(may_evict);
+    int victim;
+    if (t1_victim != nullptr && (arc_t1.size() > arc_target || (faulting_in_b2 && arc_t1.size() == arc_target) || t2_victim == nullptr)) {
+        victim = *t1_victim;
+        arc_b1.push_back(pageKey(frame_table[victim].process_id, frame_table[victim].page_number));
+    } else if (t2_victim != nullptr) {
+        victim = *t2_victim;
+        arc_b2.push_back(pageKey(frame_table[victim].process_id, frame_table[victim].page_number));
+    } else {
+        return;
+    }
+    evictFrame(victim);
+    events(1) << "ARC replacement: Replaced frame " << victim << std::endl;
+}
+
+// Disk driver thread: services the pending requests one at a time with the run's scheduler, choosing
+// only among those issued by disk_clock, so the order depends on simulated time alone. It exits once
+// stopDiskDriver has been called and every request has been serviced.
+void Simulation::diskDriverProcess() {
+    while (admitDiskRequests()) {
+        scheduler_picks++;
+        queue_depth_sum += disk_pending.size();
+        max_queue_depth = std::max(max_queue_depth, (int)disk_pending.size());
+        (this->*diskSchedulingAlgorithms[disk_algorithm])(algorithmName);
+    }
+}
+
+void Simulation::startDiskDriver() {
+    driver_stopping = false;
+    disk_driver = std::thread(&Simulation::diskDriverProcess, this);
+}
+
+// Lets the driver finish the queued requests, then joins it
+void Simulation::stopDiskDriver() {
+    lockDiskQueue();
+    driver_stopping = true;
+    issue_horizon = LONG_MAX;
+    unlockDiskQueue();
+    sem_post(&request_sem);
+    disk_driver.join();
+}
+
+// Moves the head to disk_addr and returns the simulated service time in microseconds: a linear
+// seek over the tracks crossed, then rotational latency and the page transfer
+long Simulation::calculateServiceTime(int disk_addr) {
+    int seek_distance = abs(current_head_position - disk_addr);
+    current_head_position = disk_addr; // Update the head position
+    total_seek_operations++;
+    total_seek_distance += seek_distance;
+    metrics.seek_distance.record(seek_distance);
+    return (long)seek_distance * seek_time_per_track + rotational_latency + transfer_time;
+}
+
+void Simulation::requestPageFromDisk(int frame_index, int disk_addr, int process_id, const std::vector<int>& readahead_frames) {
+    if (frame_index < 0 || frame_index >= total_frames) {
+        log << "Invalid frame index: " << frame_index << ". Cannot schedule disk I/O." << std::endl;
+        return;  // Prevent disk operations with invalid frames
     }
 
     DiskQueueEntry newRequest;
@@ -557,96 +2037,366 @@ void requestPageFromDisk(int frame_index, int disk_addr, int process_id) {
     newRequest.operation = 'R'; // Read operation
     newRequest.frame_index = frame_index;
     newRequest.disk_addr = disk_addr;
+    newRequest.cluster_end = disk_addr;
+    newRequest.readahead_frames = readahead_frames;
+    newRequest.write_pages = 0;
+    // One clustered request sweeps from the lowest to the highest track of its pages
+    for (int frame : readahead_frames) {
+        newRequest.disk_addr = std::min(newRequest.disk_addr, frame_table[frame].disk_address);
+        newRequest.cluster_end = std::max(newRequest.cluster_end, frame_table[frame].disk_address);
+    }
     scheduleDiskIO(&newRequest);
 }
 
-void optLookaheadPageReplacementWrapper(int process_id) {
-    optLookaheadPageReplacement(process_id, lookahead_window_size);
+// Queues the write-back of a dirty page being evicted. The page is copied out with the request, so
+// the frame can be reused at once; nothing waits for the write.
+void Simulation::requestWriteBack(int frame_index) {
+    const FrameTableEntry& frame = frame_table[frame_index];
+    DiskQueueEntry write = {};
+    write.process_id = frame.process_id;
+    write.operation = 'W';
+    write.frame_index = frame_index;
+    write.disk_addr = frame.disk_address;
+    write.cluster_end = frame.disk_address;
+    write.write_pages = 1;
+    writeback_pages++;
+    scheduleDiskIO(&write);
 }
 
-void workingSetPageReplacementWrapper(int process_id) {
-    workingSetPageReplacement(process_id, frames_per_process); // or another value representing delta
+// Models the translation in front of the page table: L1 TLB, then the second level, then a page
+// table walk. Only the cost is accounted; residency is still decided by the page table itself.
+void Simulation::translateAddress(int process_id, int page_number) {
+    TlbStats& stats = tlb_stats[process_id];
+    stats.references++;
+    stats.cycles += tlb_hit_cycles;
+    if (tlb.lookup(process_id, page_number) != -1) {
+        stats.l1_hits++;
+        return;
+    }
+    if (tlb2.enabled()) {
+        stats.cycles += tlb2_hit_cycles;
+        int frame_index = tlb2.lookup(process_id, page_number);
+        if (frame_index != -1) {
+            stats.l2_hits++;
+            tlb.insert(process_id, page_number, frame_index);
+            return;
+        }
+    }
+    // The walk costs page_walk_cycles for every table access the layout needs
+    PageTable& page_table = *page_tables[process_id];
+    long accesses_before = page_table.accesses;
+    PageTableEntry* entry = page_table.walk(page_number);
+    stats.walks++;
+    stats.cycles += page_walk_cycles * (page_table.accesses - accesses_before);
+    if (entry != nullptr && entry->frame_number != -1) tlbFill(process_id, page_number, entry->frame_number);
+}
+
+void Simulation::tlbFill(int process_id, int page_number, int frame_index) {
+    tlb.insert(process_id, page_number, frame_index);
+    if (tlb2.enabled()) tlb2.insert(process_id, page_number, frame_index);
+}
+
+// Without ASID tags the translations of the previous process are flushed when another one runs
+void Simulation::tlbSwitchTo(int process_id) {
+    if (!tlb.enabled() || tlb_asid_tagged || tlb_asid == process_id) return;
+    if (tlb_asid != -1) {
+        tlb.flush();
+        tlb2.flush();
+        tlb_flushes++;
+    }
+    tlb_asid = process_id;
+}
+
+// Called on a demand fault. Updates the process's stream detector and, while a stream is running,
+// loads the next window of pages along the stride into free frames. Readahead never evicts: it
+// stops at the first resident page, the end of the address space or when no frame is free.
+std::vector<int> Simulation::readaheadPages(int process_id, int page_number) {
+    std::vector<int> frames;
+    ReadaheadState& state = readahead_state[process_id];
+    if (state.stride != 0 && page_number == state.next_expected) {
+        state.window = std::min(std::max(state.window * 2, 2), readahead_max);
+    } else {
+        state.stride = state.last_fault == -1 ? 0 : page_number - state.last_fault;
+        state.window = 0;
+    }
+    state.last_fault = page_number;
+
+    int page = page_number;
+    for (int i = 0; i < state.window; i++) {
+        int next_page = page + state.stride;
+        if (!page_tables[process_id]->covers(next_page)) break;
+        PageTableEntry* entry = page_tables[process_id]->find(next_page);
+        if (entry != nullptr && entry->frame_number != -1) break;
+        if (allocation_policy > 0 && replacement_scope == 1 && resident_frames[process_id] >= frame_quota[process_id]) break;
+        int frame = findFreeFrame();
+        if (frame == -1) break;
+        installPage(frame, process_id, next_page);
+        frame_table[frame].prefetched = true;
+        frames.push_back(frame);
+        page = next_page;
+    }
+    readahead_pages += frames.size();
+    state.next_expected = page + state.stride;
+    return frames;
+}
+
+void Simulation::optPageReplacementWrapper(int process_id) {
+    optPageReplacement(process_id);
+}
+
+void Simulation::optLookaheadPageReplacementWrapper(int process_id) {
+    optLookaheadPageReplacement(process_id, lookahead_window_size);
 }
 
-void (*diskSchedulingAlgorithms[])(const std::string&) = {
-        fifoDiskScheduling,
-        sstfDiskScheduling,
-        scanDiskScheduling
+
+void (Simulation::*diskSchedulingAlgorithms[])(const std::string&) = {
+        &Simulation::fifoDiskScheduling,
+        &Simulation::sstfDiskScheduling,
+        &Simulation::scanDiskScheduling,
+        &Simulation::cscanDiskScheduling,
+        &Simulation::lookDiskScheduling,
+        &Simulation::clookDiskScheduling
 };
 
 
 
-void (*pageReplacementAlgorithms[])(int) = {
-        lifoPageReplacement,
-        lruPageReplacement,
-        mruPageReplacement,
-        lfuPageReplacement, // Make sure this is correctly implemented
-        optLookaheadPageReplacementWrapper,
-        workingSetPageReplacementWrapper
+void (Simulation::*pageReplacementAlgorithms[])(int) = {
+        &Simulation::lifoPageReplacement,
+        &Simulation::lruPageReplacement,
+        &Simulation::mruPageReplacement,
+        &Simulation::lfuPageReplacement, // Make sure this is correctly implemented
+        &Simulation::optPageReplacementWrapper,
+        &Simulation::optLookaheadPageReplacementWrapper,
+        &Simulation::workingSetPageReplacement,
+        &Simulation::clockPageReplacement,
+        &Simulation::clockProPageReplacement,
+        &Simulation::twoQueuePageReplacement,
+        &Simulation::arcPageReplacement
 };
 
 
-void handlePageFaults(int process_id, const std::string& algorithmName) {
-    const auto& addresses = memoryAddresses[process_id];
-    int process_faults = 0;
-
-    for (const MemoryAddress& addr : addresses) {
-        int page_number = extractPageNumber(addr.address, page_size);
-        PageTableEntry& pageTableEntry = page_tables[process_id][page_number];
-        if (pageTableEntry.frame_number == -1) {  // If page fault occurs
-            process_faults++;
-            int free_frame = findFreeFrame();
-            if (free_frame == -1) {  // No free frame available, run a page replacement algorithm
-                if (algorithmName.find("LIFO") != std::string::npos) lifoPageReplacement(process_id);
-                else if (algorithmName.find("LRU") != std::string::npos) lruPageReplacement(process_id);
-                else if (algorithmName.find("MRU") != std::string::npos) mruPageReplacement(process_id);
-                else if (algorithmName.find("LFU") != std::string::npos) lfuPageReplacement(process_id);
-                else if (algorithmName.find("OPT") != std::string::npos) optLookaheadPageReplacement(process_id, lookahead_window_size);
-                else if (algorithmName.find("WS") != std::string::npos) workingSetPageReplacementWrapper(process_id);
-
-                free_frame = findFreeFrame(); // Try to find a free frame again after replacement
-            }
-            if (free_frame != -1) {
-                requestPageFromDisk(free_frame, getDiskAddress(process_id, page_number), process_id);
-                // Update the page table with the frame number
-                pageTableEntry.frame_number = free_frame;
-            }
+void Simulation::handlePageFaults(int process_id, const std::string& algorithmName) {
+    ProcessContext process(process_id, memoryAddresses[process_id], nextUse[process_id]);
+    if (pageReplacementNames[page_algorithm].find("OPT") != std::string::npos) optResetQueue(process_id);
+    tlbSwitchTo(process_id);
+    while (!process.finished()) {
+        replayReference(process);
+        cpu_clock += reference_time;
+        cpu_busy += reference_time;
+    }
+    finishProcess(process, algorithmName);
+}
+
+// Replays the process's next reference; returns the frame of a page it faulted in, -1 otherwise
+int Simulation::replayReference(ProcessContext& process) {
+    int process_id = process.process_id;
+    bool tracks_next_use = policy_name.find("OPT") != std::string::npos;
+    current_reference = process.position++;
+    unsigned int address = process.cursor.next();
+    int page_number = extractPageNumber(address, page_size);
+    PageTable& page_table = *page_tables[process_id];
+    if (!page_table.covers(page_number)) {
+        log << "Address 0x" << std::hex << address << std::dec << " of process " << process_id
+                  << " is outside its " << page_table.page_limit << " pages" << std::endl;
+        return -1;
+    }
+    if (tracks_working_set) workingSetReference(process_id, page_number);
+    PageTableEntry* pageTableEntry;
+    if (tlb.enabled()) {
+        translateAddress(process_id, page_number);  // Walks the table on a TLB miss
+        pageTableEntry = page_table.find(page_number);
+    } else {
+        pageTableEntry = page_table.walk(page_number);
+    }
+    if (pageTableEntry != nullptr && pageTableEntry->frame_number != -1) {  // Hit: only the recency order changes
+        waitForDiskRead(pageTableEntry->frame_number);  // Blocks if the page is still being read in
+        FrameTableEntry& frame = frame_table[pageTableEntry->frame_number];
+        if (frame.prefetched) {
+            frame.prefetched = false;
+            readahead_used++;
+        }
+        frame.access_count++;
+        frame.referenced = true;
+        if (process.cursor.write) frame.dirty = true;
+        frame_last_reference[pageTableEntry->frame_number] = current_reference;
+        if (lfu_queued[pageTableEntry->frame_number]) lfuTouch(pageTableEntry->frame_number);
+        if (tracks_working_set) ws_outside.erase(pageTableEntry->frame_number);
+        lruTouch(pageTableEntry->frame_number);
+        // 2Q and ARC move re-referenced pages to the recency end of their main queue
+        if (two_queue_main.erase(pageTableEntry->frame_number)) two_queue_main.push_back(pageTableEntry->frame_number);
+        if (arc_t1.erase(pageTableEntry->frame_number) || arc_t2.erase(pageTableEntry->frame_number)) {
+            arc_t2.push_back(pageTableEntry->frame_number);
         }
+        if (tracks_next_use) optSetNextUse(pageTableEntry->frame_number, (*process.next_use)[current_reference]);
+        return -1;
     }
 
+    // Page fault
+    process.faults++;
+    faulting_key = pageKey(process_id, page_number);
+    if (pff_threshold > 0) pffFault(process_id);
+    if (allocation_policy > 0 && replacement_scope == 1 && resident_frames[process_id] > 0 &&
+        resident_frames[process_id] >= frame_quota[process_id]) {
+        reclaimFrame(process_id);  // At its quota: the new page replaces one of its own
+    }
+    int free_frame = findFreeFrame();
+    if (free_frame == -1) {  // Free pool empty: the fault stalls while replacement runs inline
+        reclaim_stalls++;
+        reclaimFrame(process_id);
+
+        free_frame = findFreeFrame(); // Try to find a free frame again after replacement
+    }
+    if (free_frame != -1) {
+        // Update the page table and frame table and make the page most recently used
+        installPage(free_frame, process_id, page_number);
+        frame_table[free_frame].dirty = process.cursor.write;
+        if (tlb.enabled()) tlbFill(process_id, page_number, free_frame);  // The restarted access finds it
+        if (tracks_next_use) optSetNextUse(free_frame, (*process.next_use)[current_reference]);
+        std::vector<int> readahead_frames;
+        if (uses_readahead) readahead_frames = readaheadPages(process_id, page_number);
+        requestPageFromDisk(free_frame, getDiskAddress(process_id, page_number), process_id, readahead_frames);
+    }
+    faulting_key = UINT64_MAX;  // Page daemon evictions are not on behalf of a particular page
+    refillFreePool(process_id);
+    if (pff_threshold > 0) {
+        PffState& state = pff_state[process_id];
+        state.min_frames = std::min(state.min_frames, resident_frames[process_id]);
+        state.max_frames = std::max(state.max_frames, resident_frames[process_id]);
+    }
+    return free_frame;
+}
+
+void Simulation::finishProcess(ProcessContext& process, const std::string& algorithmName) {
+    int process_id = process.process_id;
+    if (tracks_working_set) workingSetRetire(process_id);
+
     // Record the faults for this algorithm and process
-    pageFaultsPerAlgorithm[algorithmName][process_id] += process_faults;
-    std::cout << "Total page faults for Process " << process_id << " under " << algorithmName << ": " << pageFaultsPerAlgorithm[algorithmName][process_id] << "\n";
+    pageFaults[process_id] += process.faults;
+    log << "Total page faults for Process " << process_id << " under " << algorithmName << ": " << pageFaults[process_id] << "\n";
 }
 
-void processDiskRequest(const DiskQueueEntry& request, const std::string& algorithmName) {
-    if (!isValidFrameIndex(request.frame_index) || request.disk_addr == -1) {
-        total_page_faults++;
-        handlePageFaults(request.process_id, algorithmName);
-        return;
+// Replays all processes at once under the CPU scheduler. Every reference takes reftime simulated
+// microseconds of CPU. A fault blocks the process until its read completes and the CPU moves on to
+// the next ready process; round robin also preempts after quantum references. When every process
+// is blocked the CPU idles until the earliest read completes. OPT's next uses stay positions in
+// each process's own trace, since the interleaving is not known ahead.
+void Simulation::replayInterleaved(const std::string& algorithmName) {
+    std::vector<ProcessContext> processes;
+    std::deque<int> ready; // Indexes into processes, in the order they get the CPU
+    std::vector<int> blocked;
+    for (int process_id = 1; process_id <= total_processes; process_id++) {
+        processes.emplace_back(process_id, memoryAddresses[process_id], nextUse[process_id]);
+        ready.push_back(processes.size() - 1);
     }
+    int running = -1;
+    while (!ready.empty() || !blocked.empty()) {
+        // Wake the processes whose reads have completed by now, earliest completion first. The disk
+        // catches up with cpu_clock first, so which reads count as completed depends only on
+        // simulated time, never on how far the driver thread happens to be.
+        std::vector<int> woken;
+        long earliest_done = LONG_MAX;
+        lockDiskQueue();
+        if (!blocked.empty()) catchUpDisk();
+        for (auto it = blocked.begin(); it != blocked.end();) {
+            int frame_index = processes[*it].blocked_frame;
+            bool done = pending_reads[frame_index] == 0;
+            if (done && read_done_at[frame_index] <= cpu_clock) {
+                woken.push_back(*it);
+                it = blocked.erase(it);
+            } else {
+                if (done) earliest_done = std::min(earliest_done, read_done_at[frame_index]);
+                ++it;
+            }
+        }
+        std::stable_sort(woken.begin(), woken.end(), [&](int a, int b) {
+            return read_done_at[processes[a].blocked_frame] < read_done_at[processes[b].blocked_frame];
+        });
+        unlockDiskQueue();
+        ready.insert(ready.end(), woken.begin(), woken.end());
+        if (ready.empty()) {
+            // Idle: jump to the earliest completed read, or wait for the driver to finish one
+            if (earliest_done != LONG_MAX) {
+                cpu_clock = earliest_done;
+            } else {
+                lockDiskQueue();
+                for (int index : blocked) awaited_frames.push_back(processes[index].blocked_frame);
+                waitForCompletion();
+                unlockDiskQueue();
+            }
+            continue;
+        }
 
-    auto start_time = std::chrono::steady_clock::now();
+        int index = ready.front();
+        ready.pop_front();
+        ProcessContext& process = processes[index];
+        process.blocked_frame = -1;
+        if (index != running) {
+            context_switches++;
+            tlbSwitchTo(process.process_id);
+            running = index;
+        }
+        for (int slice = 0; !process.finished() && (cpu_scheduler != 1 || slice < cpu_quantum); slice++) {
+            int faulted_frame = replayReference(process);
+            cpu_clock += reference_time;
+            cpu_busy += reference_time;
+            if (faulted_frame != -1) {
+                process.blocked_frame = faulted_frame;
+                fault_blocks++;
+                break;
+            }
+        }
+        if (process.finished()) finishProcess(process, algorithmName);
+        else if (process.blocked_frame != -1) blocked.push_back(index);
+        else ready.push_back(index);
+    }
+}
 
-    int seek_distance = calculateSeekTime(request.disk_addr); // This now calculates time in microseconds
-    usleep(seek_distance + 10); // Simulating the operation time, assuming it needs microseconds
+void Simulation::processDiskRequest(const DiskQueueEntry& request, const std::string& /*algorithmName*/) {
+    if (!isValidFrameIndex(request.frame_index) || request.disk_addr == -1) {
+        disk_log << "Skipping invalid disk request for process " << request.process_id << std::endl;
+        return;
+    }
 
-    auto end_time = std::chrono::steady_clock::now();
-    auto duration = std::chrono::duration_cast<std::chrono::microseconds>(end_time - start_time).count();
-    std::cout << "Operation duration: " << duration << " microseconds." << std::endl;
+    int previous_head_position = current_head_position;
+    // A request issued after the disk went idle starts when it is issued
+    if (request.issue_clock > disk_clock) disk_clock = request.issue_clock;
+    metrics.queue_wait.record(disk_clock - request.issue_clock);
+    long service_time = calculateServiceTime(request.disk_addr);
+    int cluster_pages = request.operation == 'W' ? request.write_pages - 1 : (int)request.readahead_frames.size();
+    if (cluster_pages > 0) {
+        // The rest of the cluster follows in the same sweep: no further rotational delay per page
+        int span = request.cluster_end - request.disk_addr;
+        total_seek_distance += span;
+        current_head_position = request.cluster_end;
+        service_time += (long)span * seek_time_per_track + (long)cluster_pages * transfer_time;
+    }
+    if (request.operation == 'W') {
+        write_operations++;
+        write_time += service_time;
+    }
+    disk_clock += service_time; // Advance the virtual clock instead of sleeping
+    if (realtime_pacing) {
+        usleep(service_time);
+    }
+    diskEvents(2) << "Operation duration: " << service_time << " microseconds (disk clock " << disk_clock << ")." << std::endl;
 
     // Additional debug outputs as before
-    std::cout << "Processing disk request for process ID " << request.process_id
+    diskEvents(2) << "Processing disk request for process ID " << request.process_id
               << " with frame index " << request.frame_index
               << " at disk address " << request.disk_addr << std::endl;
-    std::cout << "Seek operation: Moved from " << (current_head_position - seek_distance)
+    diskEvents(2) << "Seek operation: Moved from " << previous_head_position
               << " to " << current_head_position
-              << " (seek distance: " << seek_distance << " tracks)." << std::endl;
+              << " (seek distance: " << abs(request.disk_addr - previous_head_position) + request.cluster_end - request.disk_addr
+              << " tracks)." << std::endl;
+    if (!request.readahead_frames.empty()) {
+        diskEvents(2) << "Read ahead " << request.readahead_frames.size() << " pages in the same request" << std::endl;
+    }
+    if (request.operation == 'W') {
+        diskEvents(2) << "Wrote back " << request.write_pages << " pages in one request" << std::endl;
+    }
 
-    frame_table[request.frame_index].process_id = request.process_id;
-    frame_table[request.frame_index].page_number = extractPageNumber(request.disk_addr, page_size);
-    frame_table[request.frame_index].disk_address = request.disk_addr;
-    frame_table[request.frame_index].access_count++;
+    // The page was mapped when the fault was handled; the frame stays pending until now
+    completeDiskRequest(request);
 }
 
 
@@ -669,7 +2419,7 @@ void simulatePageFaultsAndOutputResults(const char* filename) {
             std::cout << "***** TOTAL REPLACEMENT FAULTS: " << totalFaults << " *****\n\n";
 
             // Output min and max working set sizes for each process
-            for (auto& ws : working_set_sizes) {
+            for (auto& ws : workingSetSizesPerAlgorithm[algorithmName]) {
                 std::cout << "Process " << ws.first << " Working Set Sizes\n";
                 std::cout << "MIN: " << ws.second.first << "\n";
                 std::cout << "MAX: " << ws.second.second << "\n\n";
@@ -681,96 +2431,859 @@ void resetPageFaults() {
     pageFaultsPerAlgorithm.clear();  // Clear existing records
 }
 
-void outputResultsForAlgorithmPair(const std::string& algorithmName) {
+void Simulation::outputResultsForAlgorithmPair(const std::string& algorithmName) {
     auto start_time = std::chrono::steady_clock::now();  // Start timing the simulation for the algorithm pair
 
-    // Simulate the disk scheduling and page replacement for each process
+    // Simulate the disk scheduling and page replacement for each process. Faults queue their reads
+    // for the driver thread and carry on; a process only blocks when it needs a page still in flight.
     int totalReplacements = 0;
-    for (int process_id = 1; process_id <= total_processes; process_id++) {
-        // Depending on the algorithm, the appropriate scheduling or replacement is called here
-        handlePageFaults(process_id, algorithmName);
-        // Sum up total replacements made for this algorithm combination
-        totalReplacements += pageFaultsPerAlgorithm[algorithmName][process_id];
+    startDiskDriver();
+    if (interleaved) {
+        replayInterleaved(algorithmName);
+        for (const auto& pf : pageFaults) totalReplacements += pf.second;
+    } else {
+        for (int process_id = 1; process_id <= total_processes; process_id++) {
+            // The replacement policy of this run is called from the fault path
+            handlePageFaults(process_id, algorithmName);
+            // Sum up total replacements made for this algorithm combination
+            totalReplacements += pageFaults[process_id];
+        }
     }
+    stopDiskDriver();
+    log << disk_log.str();
 
     auto end_time = std::chrono::steady_clock::now();  // End timing after processing all page faults
     auto duration = std::chrono::duration_cast<std::chrono::microseconds>(end_time - start_time).count();  // Calculate duration in microseconds
 
     // Output the results
-    std::cout << "Results for " << algorithmName << ":\n";
-    std::cout << "Simulation took " << duration << " microseconds\n";  // Report the timing for this algorithm pair
-    auto& faultsPerProcess = pageFaultsPerAlgorithm[algorithmName];
-    for (const auto& pf : faultsPerProcess) {
-        std::cout << "Process " << pf.first << ": " << pf.second << " faults\n";
+    log << "Results for " << algorithmName << ":\n";
+    log << "Simulation took " << duration << " microseconds\n";  // Report the timing for this algorithm pair
+    for (const auto& pf : pageFaults) {
+        log << "Process " << pf.first << ": " << pf.second << " faults\n";
     }
 
-    std::cout << "Total replacements for " << algorithmName << ": " << totalReplacements << "\n";
+    log << "Total replacements for " << algorithmName << ": " << totalReplacements << "\n";
+    if (sample_rate < 1.0) {
+        log << "Estimated faults for the whole trace: " << std::llround(totalReplacements / sample_rate)
+            << " (" << sample_rate * 100 << "% of pages sampled)\n";
+    }
+    if (allocation_policy > 0) {
+        for (const auto& pf : pageFaults) {
+            long references = std::max<long>(memoryAddresses[pf.first].size(), 1);
+            log << "Process " << pf.first << ": " << frame_quota[pf.first] << " frames ("
+                << allocationPolicyNames[allocation_policy] << ", " << (replacement_scope ? "local" : "global")
+                << "), " << 1000.0 * pf.second / references << " faults per 1000 references\n";
+        }
+    }
+    for (const auto& pff : pff_state) {
+        const PffState& state = pff.second;
+        log << "PFF for Process " << pff.first << ": " << state.min_frames << "-" << state.max_frames
+            << " frames, grew on " << state.grows << " faults, shrank on " << state.shrinks
+            << " releasing " << state.released << " frames\n";
+    }
 
     // Output the Working Set sizes if the algorithm is "WS"
     if (algorithmName.find("WS") != std::string::npos) {
         for (const auto& ws : working_set_sizes) {
-            std::cout << "Working Set sizes for Process " << ws.first << ":\n";
-            std::cout << "  MIN: " << ws.second.first << "\n";
-            std::cout << "  MAX: " << ws.second.second << "\n";
+            log << "Working Set sizes for Process " << ws.first << ":\n";
+            log << "  MIN: " << ws.second.first << "\n";
+            log << "  MAX: " << ws.second.second << "\n";
         }
     }
 
     // Also output the accumulated statistics like total and average seek times, if applicable
     if (total_seek_operations > 0) {
         double average_seek_time = static_cast<double>(total_seek_distance) / total_seek_operations;
-        std::cout << "Total seek operations: " << total_seek_operations << "\n";
-        std::cout << "Total seek distance: " << total_seek_distance << " tracks\n";
-        std::cout << "Average seek time: " << average_seek_time << " tracks/operation\n";
+        log << "Total seek operations: " << total_seek_operations << "\n";
+        log << "Total seek distance: " << total_seek_distance << " tracks\n";
+        log << "Average seek time: " << average_seek_time << " tracks/operation\n";
+        log << "Simulated disk time: " << disk_clock << " microseconds\n";
+    }
+    if (queued_requests > 0) {
+        log << "Disk queue depth: average " << static_cast<double>(queue_depth_sum) / std::max(scheduler_picks, 1L)
+            << ", max " << max_queue_depth << "\n";
+        log << "Average disk wait: " << static_cast<double>(total_io_wait) / queued_requests << " microseconds (simulated)\n";
+        log << "Fault service time: p50 " << metrics.fault_service.percentile(50) << ", p99 "
+            << metrics.fault_service.percentile(99) << ", max " << metrics.fault_service.max() << " microseconds (simulated)\n";
+        log << "Seek distance: p50 " << metrics.seek_distance.percentile(50) << ", p99 "
+            << metrics.seek_distance.percentile(99) << ", max " << metrics.seek_distance.max() << " tracks\n";
+    }
+    log << "References blocked on in-flight reads: " << blocked_reads << " (" << blocked_time << " microseconds simulated)\n";
+    if (uses_readahead) {
+        log << "Readahead: up to " << readahead_max << " pages, " << readahead_pages << " pages prefetched, "
+            << readahead_used << " used, " << readahead_wasted << " evicted unused\n";
+    } else if (readahead_max > 0) {
+        log << "Readahead: off for this policy, so its faults are not comparable with the prefetching runs\n";
+    }
+    for (const auto& entry : tlb_stats) {
+        const TlbStats& stats = entry.second;
+        if (stats.references == 0) continue;
+        log << "TLB for Process " << entry.first << ": "
+            << 100.0 * (stats.l1_hits + stats.l2_hits) / stats.references << "% hits ("
+            << 100.0 * stats.l1_hits / stats.references << "% L1, "
+            << 100.0 * stats.l2_hits / stats.references << "% L2), "
+            << static_cast<double>(stats.cycles) / stats.references << " translation cycles/reference\n";
+    }
+    if (tlb_flushes > 0) log << "TLB flushes on process switch: " << tlb_flushes << "\n";
+    size_t page_table_bytes = 0;
+    long page_table_lookups = 0, page_table_accesses = 0;
+    for (int process_id = 1; process_id <= total_processes; process_id++) {
+        page_table_bytes += page_tables[process_id]->footprint();
+        page_table_lookups += page_tables[process_id]->lookups;
+        page_table_accesses += page_tables[process_id]->accesses;
+    }
+    log << "Page tables (" << pageTableNames[page_table_kind] << "): " << page_table_bytes << " bytes";
+    if (page_table_lookups > 0) {
+        log << ", " << static_cast<double>(page_table_accesses) / page_table_lookups << " memory accesses per walk";
+    }
+    log << "\n";
+    if (interleaved) {
+        log << "CPU: " << context_switches << " context switches, " << fault_blocks << " blocked on faults, "
+            << 100.0 * cpu_busy / std::max(cpu_clock, 1L) << "% utilization over " << cpu_clock << " microseconds (simulated)\n";
     }
+    if (writeback_pages > 0) {
+        log << "Write-back: " << writeback_pages << " dirty pages in " << write_operations << " disk writes ("
+            << writeback_pages - write_operations << " saved by coalescing), " << write_time << " microseconds (simulated)\n";
+    }
+    log << "Faults stalled on reclaim: " << reclaim_stalls << "\n";
+    log << "Page daemon runs: " << daemon_runs << " (" << daemon_evictions << " frames freed)\n";
+
+    log << "----------------------------------------\n";
 
-    std::cout << "----------------------------------------\n";
+    metrics.disk_algorithm = diskSchedulingNames[disk_algorithm];
+    metrics.page_algorithm = pageReplacementNames[page_algorithm];
+    for (const auto& pf : pageFaults) {
+        metrics.references += memoryAddresses[pf.first].size();
+        metrics.faults += pf.second;
+    }
+    metrics.reclaim_stalls = reclaim_stalls;
+    metrics.daemon_evictions = daemon_evictions;
+    metrics.readahead_pages = readahead_pages;
+    metrics.writeback_pages = writeback_pages;
+    metrics.write_operations = write_operations;
+    metrics.simulated_disk_time = disk_clock;
 }
 
-void simulateAlgorithmPair(const std::string& diskAlgorithm, const std::string& pageAlgorithm) {
-    std::string algorithmName = diskAlgorithm + " + " + pageAlgorithm;
-    resetPageFaults();  // Reset before simulation
+void Simulation::simulateAlgorithmPair() {
+    // Replay every process under this run's replacement policy, then output the results
+    outputResultsForAlgorithmPair(algorithmName);
+}
 
-    // Simulate disk scheduling
-    if (diskAlgorithm == "FIFO") fifoDiskScheduling(algorithmName);
-    else if (diskAlgorithm == "SSTF") sstfDiskScheduling(algorithmName);
-    else if (diskAlgorithm == "SCAN") scanDiskScheduling(algorithmName);
+// Runs every disk scheduling x page replacement pair on a pool of worker threads. Each pair gets
+// its own Simulation; the results are merged and printed in matrix order once all of them are
+// done, so the output is the same whichever thread finishes first.
+void runAllAlgorithmPairs() {
+    struct PairResult {
+        std::string algorithmName;
+        std::string output;
+        std::map<int, int> pageFaults;
+        std::unordered_map<int, std::pair<int, int>> working_set_sizes;
+        RunMetrics metrics;
+    };
+    size_t pair_count = diskSchedulingNames.size() * pageReplacementNames.size();
+    std::vector<PairResult> results(pair_count);
+    std::atomic<size_t> next_pair(0);
+
+    auto worker = [&]() {
+        for (size_t i = next_pair++; i < pair_count; i = next_pair++) {
+            Simulation simulation(i / pageReplacementNames.size(), i % pageReplacementNames.size());
+            simulation.simulateAlgorithmPair();
+            results[i] = {simulation.algorithmName, simulation.log.str(), simulation.pageFaults,
+                          simulation.working_set_sizes, simulation.metrics};
+        }
+    };
 
-    // Simulate page replacement for each process
-    for (int process_id = 1; process_id <= total_processes; process_id++) {
-        if (pageAlgorithm == "LIFO") lifoPageReplacement(process_id);
-        else if (pageAlgorithm == "LRU") lruPageReplacement(process_id);
-        else if (pageAlgorithm == "MRU") mruPageReplacement(process_id);
-        else if (pageAlgorithm == "LFU") lfuPageReplacement(process_id);
-        else if (pageAlgorithm == "OPT") optLookaheadPageReplacement(process_id, lookahead_window_size);
-        else if (pageAlgorithm == "WS") workingSetPageReplacementWrapper(process_id);
+    size_t thread_count = std::max(1u, std::thread::hardware_concurrency());
+    thread_count = std::min(thread_count, pair_count);
+    std::vector<std::thread> pool;
+    for (size_t t = 0; t < thread_count; t++) {
+        pool.emplace_back(worker);
+    }
+    for (auto& thread : pool) {
+        thread.join();
+    }
 
-        handlePageFaults(process_id, algorithmName);  // Handle and record page faults
+    for (const auto& result : results) {
+        std::cout << result.output;
+        pageFaultsPerAlgorithm[result.algorithmName] = result.pageFaults;
+        workingSetSizesPerAlgorithm[result.algorithmName] = result.working_set_sizes;
+        runMetrics.push_back(result.metrics);
     }
+    std::cout.flush();
+}
 
-    // Output the results for this algorithm combination
-    outputResultsForAlgorithmPair(algorithmName);
+// --benchmark: replays each replacement policy once (FIFO disk scheduling, results discarded) in a
+// child process of its own, so every policy starts from the same loaded state and gets its own peak
+// resident set, and reports the simulator's throughput and memory
+void runBenchmark() {
+    long references = 0;
+    for (int process_id = 1; process_id <= total_processes; process_id++) {
+        references += memoryAddresses[process_id].size();
+    }
+    struct rusage loaded;
+    getrusage(RUSAGE_SELF, &loaded);
+    std::cout << "Benchmark: " << references << " references, " << loaded.ru_maxrss << " KB resident after loading" << std::endl;
+
+    for (size_t policy = 0; policy < pageReplacementNames.size(); policy++) {
+        int channel[2];
+        if (pipe(channel) == -1) {
+            perror("pipe failed");
+            exit(EXIT_FAILURE);
+        }
+        pid_t child = fork();
+        if (child < 0) {
+            perror("fork failed");
+            exit(EXIT_FAILURE);
+        }
+        if (child == 0) {
+            close(channel[0]);
+            auto start_time = std::chrono::steady_clock::now();
+            {
+                Simulation simulation(0, policy);
+                simulation.simulateAlgorithmPair();
+            }
+            double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start_time).count();
+            ssize_t written = write(channel[1], &seconds, sizeof(seconds));
+            _exit(written == sizeof(seconds) ? EXIT_SUCCESS : EXIT_FAILURE);
+        }
+        close(channel[1]);
+        double seconds = 0;
+        bool timed = read(channel[0], &seconds, sizeof(seconds)) == sizeof(seconds) && seconds > 0;
+        close(channel[0]);
+        int status;
+        struct rusage usage;
+        wait4(child, &status, 0, &usage);
+        if (!timed || !WIFEXITED(status) || WEXITSTATUS(status) != EXIT_SUCCESS) {
+            std::cout << pageReplacementNames[policy] << ": run failed" << std::endl;
+            continue;
+        }
+        std::cout << pageReplacementNames[policy] << ": " << static_cast<long>(references / seconds)
+                  << " references/s (" << seconds * 1000 << " ms), peak RSS " << usage.ru_maxrss << " KB" << std::endl;
+    }
 }
 
+// Parameters of a synthetic workload written by --generate
+struct TraceSpec {
+    std::string pattern; // sequential, loop, random, zipf or phases
+    std::string layout = "contiguous"; // Track placement: contiguous, striped or random
+    std::vector<int> pages = {64}; // Pages of each process; the last size repeats for the rest
+    int processes = 2;
+    long references = 10000; // Per process
+    int frames = 32, page_size = 4096, max_track = 500;
+    double zipf_exponent = 0.99;
+    double write_fraction = 0; // Share of references that are writes
+    unsigned seed = 1;
+};
 
+// Writes a synthetic workload in the input format. Per process, the patterns are:
+//   sequential  a stream through the pages, four references per page, wrapping at the end
+//   loop        one reference per page, cycling over all pages
+//   random      pages drawn uniformly
+//   zipf        page ranks drawn with P(rank) ~ 1 / rank^s, the hot ranks scattered over the pages
+//   phases      uniform over a window of an eighth of the pages that jumps to a new place eight
+//               times over the trace, for working set and PFF experiments
+// contiguous gives each process its own band of tracks, striped interleaves the processes' pages
+// across the whole disk and random places every page on a random track.
+void writeSyntheticTrace(const TraceSpec& spec, const char* filename) {
+    std::ofstream out(filename);
+    if (!out) {
+        std::cerr << "Failed to open trace output: " << filename << std::endl;
+        exit(EXIT_FAILURE);
+    }
+    std::mt19937 random(spec.seed);
+    int tracks = spec.max_track + 1;
+    out << "tp " << spec.frames << "\nps " << spec.page_size << "\nr " << std::max(spec.frames / spec.processes, 1)
+        << "\nX 3\nmin " << std::max(spec.frames / 10, 1) << "\nmax " << std::max(spec.frames / 5, 2)
+        << "\nk " << spec.processes << "\nmaxtrack " << spec.max_track << "\ny 10\n";
+
+    auto pagesOf = [&spec](int process_id) { return spec.pages[std::min<size_t>(process_id - 1, spec.pages.size() - 1)]; };
+    for (int process_id = 1; process_id <= spec.processes; process_id++) {
+        int pages = pagesOf(process_id);
+        int band = std::max(tracks / spec.processes, 1);
+        out << "pid" << process_id << " " << pages << "\n";
+        for (int page = 0; page < pages; page++) {
+            long track;
+            if (spec.layout == "striped") track = ((long)page * tracks / pages + process_id - 1) % tracks;
+            else if (spec.layout == "random") track = random() % tracks;
+            else track = std::min<long>((long)(process_id - 1) * band + (long)page * band / pages, spec.max_track);
+            out << page << " " << track << "\n";
+        }
+    }
 
+    for (int process_id = 1; process_id <= spec.processes; process_id++) {
+        int pages = pagesOf(process_id);
+        std::uniform_int_distribution<int> uniform_page(0, pages - 1);
+        std::uniform_int_distribution<int> offset(0, spec.page_size - 1);
+        std::vector<double> zipf_cdf;
+        std::vector<int> zipf_page(pages);
+        if (spec.pattern == "zipf") {
+            double total = 0;
+            for (int rank = 1; rank <= pages; rank++) {
+                total += 1.0 / std::pow(rank, spec.zipf_exponent);
+                zipf_cdf.push_back(total);
+            }
+            for (int rank = 0; rank < pages; rank++) zipf_page[rank] = rank;
+            std::shuffle(zipf_page.begin(), zipf_page.end(), random);
+        }
+        std::uniform_real_distribution<double> unit(0.0, 1.0);
+        int window = std::max(pages / 8, 1), window_start = 0;
+        long phase_length = std::max(spec.references / 8, 1L);
+
+        for (long i = 0; i < spec.references; i++) {
+            long address;
+            if (spec.pattern == "sequential") {
+                long position = i % ((long)pages * 4);
+                address = position / 4 * spec.page_size + position % 4 * (spec.page_size / 4);
+            } else if (spec.pattern == "loop") {
+                address = (i % pages) * spec.page_size + offset(random);
+            } else if (spec.pattern == "zipf") {
+                double u = unit(random) * zipf_cdf.back();
+                int rank = std::lower_bound(zipf_cdf.begin(), zipf_cdf.end(), u) - zipf_cdf.begin();
+                address = (long)zipf_page[std::min(rank, pages - 1)] * spec.page_size + offset(random);
+            } else if (spec.pattern == "phases") {
+                if (i % phase_length == 0) window_start = random() % std::max(pages - window + 1, 1);
+                address = (long)(window_start + random() % window) * spec.page_size + offset(random);
+            } else {
+                address = (long)uniform_page(random) * spec.page_size + offset(random);
+            }
+            out << "pid" << process_id << " 0x" << std::hex << address << std::dec;
+            if (spec.write_fraction > 0 && unit(random) < spec.write_fraction) out << " W";
+            out << "\n";
+        }
+    }
+    for (int process_id = 1; process_id <= spec.processes; process_id++) {
+        out << process_id << " -1\n";
+    }
+    std::cout << "Synthetic " << spec.pattern << " trace written to " << filename << std::endl;
+}
 
-int main(int argc, char *argv[]) {
-    if (argc != 2) {
-        std::cerr << "Usage: " << argv[0] << " <configuration file>\n";
+// --generate <pattern> <output.txt> [--processes k] [--pages n[,n...]] [--references n] [--frames tp]
+//            [--layout contiguous|striped|random] [--zipf s] [--writes fraction] [--seed n]
+int generateTrace(int argc, char* argv[]) {
+    static const std::set<std::string> patterns = {"sequential", "loop", "random", "zipf", "phases"};
+    static const std::set<std::string> layouts = {"contiguous", "striped", "random"};
+    bool usage_error = argc < 4 || patterns.count(argv[2]) == 0;
+    TraceSpec spec;
+    if (!usage_error) spec.pattern = argv[2];
+    for (int i = 4; i < argc && !usage_error; i += 2) {
+        std::string option = argv[i];
+        if (i + 1 >= argc) usage_error = true;
+        else if (option == "--processes") spec.processes = std::atoi(argv[i + 1]);
+        else if (option == "--references") spec.references = std::atol(argv[i + 1]);
+        else if (option == "--frames") spec.frames = std::atoi(argv[i + 1]);
+        else if (option == "--layout") spec.layout = argv[i + 1];
+        else if (option == "--zipf") spec.zipf_exponent = std::atof(argv[i + 1]);
+        else if (option == "--writes") spec.write_fraction = std::atof(argv[i + 1]);
+        else if (option == "--seed") spec.seed = std::strtoul(argv[i + 1], nullptr, 10);
+        else if (option == "--pages") {
+            spec.pages.clear();
+            std::istringstream sizes(argv[i + 1]);
+            std::string size;
+            while (getline(sizes, size, ',')) spec.pages.push_back(std::max(std::atoi(size.c_str()), 1));
+            usage_error = spec.pages.empty();
+        } else usage_error = true;
+    }
+    if (usage_error || spec.processes < 1 || spec.references < 1 || spec.frames < 1 || layouts.count(spec.layout) == 0) {
+        std::cerr << "Usage: " << argv[0] << " --generate <sequential|loop|random|zipf|phases> <output.txt>"
+                     " [--processes k] [--pages n[,n...]] [--references n] [--frames tp]"
+                     " [--layout contiguous|striped|random] [--zipf s] [--writes fraction] [--seed n]\n";
         return EXIT_FAILURE;
     }
+    writeSyntheticTrace(spec, argv[3]);
+    return 0;
+}
 
-    readConfiguration(argv[1]);
-    initializeGlobals();
-    initializeSemaphores();
-    initFrameTable(total_frames);
+// One object per algorithm pair: the counters, then each histogram's count, mean and percentiles
+void writeMetricsJson(const char* filename) {
+    std::ofstream out(filename);
+    if (!out) {
+        std::cerr << "Failed to open metrics output: " << filename << std::endl;
+        exit(EXIT_FAILURE);
+    }
+    auto histogram = [&out](const char* name, const Histogram& h) {
+        out << ", \"" << name << "\": {\"count\": " << h.count() << ", \"min\": " << h.min()
+            << ", \"mean\": " << h.mean() << ", \"p50\": " << h.percentile(50) << ", \"p90\": " << h.percentile(90)
+            << ", \"p99\": " << h.percentile(99) << ", \"max\": " << h.max() << "}";
+    };
+    out << "[\n";
+    for (size_t i = 0; i < runMetrics.size(); i++) {
+        const RunMetrics& m = runMetrics[i];
+        out << "  {\"disk\": \"" << m.disk_algorithm << "\", \"policy\": \"" << m.page_algorithm << "\""
+            << ", \"references\": " << m.references << ", \"faults\": " << m.faults
+            << ", \"evictions\": " << m.evictions << ", \"reclaim_stalls\": " << m.reclaim_stalls
+            << ", \"daemon_evictions\": " << m.daemon_evictions << ", \"readahead_pages\": " << m.readahead_pages
+            << ", \"writeback_pages\": " << m.writeback_pages << ", \"write_operations\": " << m.write_operations
+            << ", \"simulated_disk_time_us\": " << m.simulated_disk_time;
+        histogram("fault_service_us", m.fault_service);
+        histogram("queue_wait_us", m.queue_wait);
+        histogram("seek_distance_tracks", m.seek_distance);
+        out << "}" << (i + 1 < runMetrics.size() ? "," : "") << "\n";
+    }
+    out << "]\n";
+    std::cout << "Metrics written to " << filename << std::endl;
+}
 
-    // Run simulation for each combination of disk scheduling and page replacement
-    for (const auto& diskAlgorithm : diskSchedulingNames) {
-        for (const auto& pageAlgorithm : pageReplacementNames) {
-            simulateAlgorithmPair(diskAlgorithm, pageAlgorithm);
+// One row per algorithm pair with the histograms flattened into <name>_<statistic> columns
+void writeMetricsCsv(const char* filename) {
+    std::ofstream out(filename);
+    if (!out) {
+        std::cerr << "Failed to open metrics output: " << filename << std::endl;
+        exit(EXIT_FAILURE);
+    }
+    const char* histograms[] = {"fault_service_us", "queue_wait_us", "seek_distance_tracks"};
+    out << "disk,policy,references,faults,evictions,reclaim_stalls,daemon_evictions,readahead_pages,writeback_pages,"
+           "write_operations,simulated_disk_time_us";
+    for (const char* name : histograms) {
+        for (const char* statistic : {"count", "mean", "p50", "p90", "p99", "max"}) out << ',' << name << '_' << statistic;
+    }
+    out << '\n';
+    for (const RunMetrics& m : runMetrics) {
+        out << m.disk_algorithm << ',' << m.page_algorithm << ',' << m.references << ',' << m.faults << ','
+            << m.evictions << ',' << m.reclaim_stalls << ',' << m.daemon_evictions << ',' << m.readahead_pages << ','
+            << m.writeback_pages << ',' << m.write_operations << ',' << m.simulated_disk_time;
+        for (const Histogram* h : {&m.fault_service, &m.queue_wait, &m.seek_distance}) {
+            out << ',' << h->count() << ',' << h->mean() << ',' << h->percentile(50) << ',' << h->percentile(90)
+                << ',' << h->percentile(99) << ',' << h->max();
         }
+        out << '\n';
     }
+    std::cout << "Metrics written to " << filename << std::endl;
+}
+
+// Mattson stack-distance engine. One pass over a process's trace computes, for every reference,
+// how many distinct pages were referenced since the previous reference to the same page. An LRU
+// memory of m frames hits exactly the references with distance <= m, so the histogram of
+// distances gives the LRU fault count for every memory size at once. The distinct pages since the
+// previous reference are counted with a Fenwick tree holding a 1 at the latest reference position
+// of every page, so each reference costs O(log n).
+struct MissRatioCurve {
+    int process_id;
+    double references = 0;
+    double cold_misses = 0; // First references, a fault at every memory size
+    std::vector<double> distance_histogram; // distance_histogram[d]: references with stack distance d
+    double sample_rate = 1.0; // Final sampling rate when the curve was estimated from a sample
+};
+
+MissRatioCurve computeMissRatioCurve(int process_id) {
+    MissRatioCurve curve;
+    curve.process_id = process_id;
+    const AddressTrace& addresses = memoryAddresses[process_id];
+    TraceCursor cursor(addresses);
+    int n = addresses.size();
+    std::vector<int> fenwick(n + 1, 0);
+    std::unordered_map<int, int> last_reference; // page -> 1-based position of its latest reference
+    auto add = [&](int position, int delta) {
+        for (; position <= n; position += position & -position) fenwick[position] += delta;
+    };
+    auto prefix = [&](int position) {
+        int sum = 0;
+        for (; position > 0; position -= position & -position) sum += fenwick[position];
+        return sum;
+    };
+
+    curve.distance_histogram.assign(2, 0);
+    for (int i = 1; i <= n; ++i) {
+        int page_number = extractPageNumber(cursor.next(), page_size);
+        auto it = last_reference.find(page_number);
+        if (it == last_reference.end()) {
+            curve.cold_misses++;
+            last_reference.emplace(page_number, i);
+        } else {
+            // Pages whose latest reference falls after this page's, plus the page itself
+            int distance = prefix(i - 1) - prefix(it->second) + 1;
+            if (distance >= (int)curve.distance_histogram.size()) curve.distance_histogram.resize(distance + 1, 0);
+            curve.distance_histogram[distance]++;
+            add(it->second, -1);
+            it->second = i;
+        }
+        add(i, 1);
+    }
+    curve.references = n;
+    return curve;
+}
+
+// SHARDS spatial sampling. A page is kept when the hash of (process, page) falls below
+// threshold / SAMPLE_MODULUS, so either every reference to a page is kept or none is, and a sample
+// at rate R behaves like the whole trace scaled down by R: stack distances shrink by R, and so do
+// fault counts at tp * R frames.
+const uint64_t SAMPLE_MODULUS = 1 << 24;
+const size_t SAMPLE_MAX_PAGES = 8192; // Cap on sampled pages kept by the miss ratio curve estimator
+
+inline uint64_t sampleHash(int process_id, int page_number) {
+    uint64_t x = pageKey(process_id, page_number) + 0x9e3779b97f4a7c15ULL;  // splitmix64 finalizer
+    x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+    return (x ^ (x >> 31)) % SAMPLE_MODULUS;
+}
+
+// Fixed-size SHARDS: stack distances over the sampled pages only, each standing for distance / R
+// pages and weighted 1 / R. Starting at the given rate, whenever more than SAMPLE_MAX_PAGES pages are
+// sampled the threshold drops to the largest hash kept, dropping those pages and lowering R, so the
+// state stays O(SAMPLE_MAX_PAGES) however long the trace. Distances count the sampled pages whose
+// latest reference is newer, with a Fenwick tree over timestamps that is renumbered when they run out.
+MissRatioCurve computeSampledMissRatioCurve(int process_id, double rate) {
+    MissRatioCurve curve;
+    curve.process_id = process_id;
+    const AddressTrace& addresses = memoryAddresses[process_id];
+    TraceCursor cursor(addresses);
+    uint64_t threshold = std::max<uint64_t>(1, (uint64_t)(rate * SAMPLE_MODULUS));
+    std::unordered_map<int, int> last_reference; // Sampled page -> timestamp of its latest reference
+    std::set<std::pair<uint64_t, int>> by_hash; // Sampled pages, largest hash dropped first
+    const int capacity = 2 * SAMPLE_MAX_PAGES + 2;
+    std::vector<int> fenwick(capacity + 1, 0);
+    int clock = 0;
+    auto add = [&](int position, int delta) {
+        for (; position <= capacity; position += position & -position) fenwick[position] += delta;
+    };
+    auto prefix = [&](int position) {
+        int sum = 0;
+        for (; position > 0; position -= position & -position) sum += fenwick[position];
+        return sum;
+    };
+    auto renumber = [&]() {
+        std::vector<std::pair<int, int>> live; // (timestamp, page)
+        for (const auto& page : last_reference) live.push_back({page.second, page.first});
+        std::sort(live.begin(), live.end());
+        std::fill(fenwick.begin(), fenwick.end(), 0);
+        clock = 0;
+        for (const auto& page : live) {
+            last_reference[page.second] = ++clock;
+            add(clock, 1);
+        }
+    };
+
+    curve.distance_histogram.assign(2, 0);
+    for (size_t i = 0; i < addresses.size(); ++i) {
+        int page_number = extractPageNumber(cursor.next(), page_size);
+        uint64_t hash = sampleHash(process_id, page_number);
+        if (hash >= threshold) continue;
+        double scale = (double)SAMPLE_MODULUS / threshold; // 1 / R
+        if (clock == capacity) renumber();
+        auto it = last_reference.find(page_number);
+        if (it == last_reference.end()) {
+            curve.cold_misses += scale;
+            last_reference.emplace(page_number, ++clock);
+            by_hash.insert({hash, page_number});
+            add(clock, 1);
+            while (by_hash.size() > SAMPLE_MAX_PAGES) {
+                auto largest = std::prev(by_hash.end());
+                threshold = largest->first;
+                add(last_reference[largest->second], -1);
+                last_reference.erase(largest->second);
+                by_hash.erase(largest);
+            }
+        } else {
+            int distance = prefix(clock) - prefix(it->second) + 1;
+            size_t scaled = std::max<size_t>(1, (size_t)std::llround(distance * scale));
+            if (scaled >= curve.distance_histogram.size()) curve.distance_histogram.resize(scaled + 1, 0);
+            curve.distance_histogram[scaled] += scale;
+            add(it->second, -1);
+            it->second = ++clock;
+            add(clock, 1);
+        }
+        curve.references += scale;
+    }
+    curve.sample_rate = (double)threshold / SAMPLE_MODULUS;
+    return curve;
+}
+
+// faults[m] for m = 1 .. the distinct pages: cold misses + references with distance > m,
+// accumulated from the largest distance down
+std::vector<double> missRatioFaults(const MissRatioCurve& curve) {
+    int max_frames = std::max<int>(std::llround(curve.cold_misses), 1);
+    std::vector<double> faults(max_frames + 1, curve.cold_misses);
+    double deeper = 0;
+    for (int m = (int)curve.distance_histogram.size() - 1; m >= 1; --m) {
+        if (m <= max_frames) faults[m] += deeper;
+        deeper += curve.distance_histogram[m];
+    }
+    for (int m = (int)curve.distance_histogram.size(); m <= max_frames; ++m) faults[m] = curve.cold_misses;
+    return faults;
+}
+
+// Writes process_id,frames,faults,miss_ratio for every memory size from 1 frame up to the number of
+// distinct pages the process touches (beyond that only cold misses remain). With --sample the
+// curves are SHARDS estimates.
+void exportMissRatioCurves(const char* filename) {
+    std::ofstream out(filename);
+    if (!out) {
+        std::cerr << "Failed to open miss ratio curve output: " << filename << std::endl;
+        exit(EXIT_FAILURE);
+    }
+    out << "process_id,frames,faults,miss_ratio\n";
+    for (int process_id = 1; process_id <= total_processes; process_id++) {
+        MissRatioCurve curve = sample_rate < 1.0 ? computeSampledMissRatioCurve(process_id, sample_rate)
+                                                 : computeMissRatioCurve(process_id);
+        std::vector<double> faults = missRatioFaults(curve);
+        for (int m = 1; m < (int)faults.size(); ++m) {
+            double ratio = curve.references > 0 ? faults[m] / curve.references : 0.0;
+            out << process_id << ',' << m << ',' << std::llround(faults[m]) << ',' << ratio << '\n';
+        }
+        std::cout << "Miss ratio curve for process " << process_id << ": " << std::llround(curve.references)
+                  << " references, " << std::llround(curve.cold_misses) << " distinct pages";
+        if (curve.sample_rate < 1.0) std::cout << " (estimated at sampling rate " << curve.sample_rate << ")";
+        std::cout << std::endl;
+    }
+    std::cout << "Miss ratio curves written to " << filename << std::endl;
+}
+
+// Fixed-rate sampling for the simulations: drops every reference to an unsampled page and scales the
+// frame counts and the settings measured in references (X, wsdelta, pff, lfuage, quantum) by the
+// rate. Each run then reports its faults divided by the rate as the estimate for the whole trace.
+void applySpatialSampling(double rate) {
+    uint64_t threshold = std::max<uint64_t>(1, (uint64_t)(rate * SAMPLE_MODULUS));
+    for (int process_id = 1; process_id <= total_processes; process_id++) {
+        const AddressTrace& addresses = memoryAddresses[process_id];
+        AddressTrace sampled;
+        TraceCursor cursor(addresses);
+        for (size_t i = 0; i < addresses.size(); ++i) {
+            unsigned int address = cursor.next();
+            if (sampleHash(process_id, extractPageNumber(address, page_size)) < threshold) sampled.append(address, cursor.write);
+        }
+        std::cout << "Process " << process_id << ": sampled " << sampled.size() << " of " << addresses.size() << " references" << std::endl;
+        memoryAddresses[process_id] = std::move(sampled);
+    }
+    auto scale = [rate](int value) { return value > 0 ? std::max(1, (int)std::lround(value * rate)) : 0; };
+    total_frames = scale(total_frames);
+    frames_per_process = scale(frames_per_process);
+    min_free_pool_size = scale(min_free_pool_size);
+    max_free_pool_size = scale(max_free_pool_size);
+    working_set_window = scale(working_set_window);
+    pff_threshold = scale(pff_threshold);
+    lookahead_window_size = scale(lookahead_window_size);
+    lfu_aging_interval = scale(lfu_aging_interval);
+    cpu_quantum = scale(cpu_quantum);
+    sample_rate = rate;
+    std::cout << "Sampling " << rate * 100 << "% of pages: " << total_frames << " frames" << std::endl;
+}
+
+// --sample-check: the exact and the sampled answer side by side, to measure the sampling error on a
+// trace small enough to simulate in full. Compares each process's miss ratio curve (mean absolute
+// error over all memory sizes) and the total faults of every policy under FIFO disk scheduling.
+void checkSampling(double rate) {
+    for (int process_id = 1; process_id <= total_processes; process_id++) {
+        std::vector<double> exact = missRatioFaults(computeMissRatioCurve(process_id));
+        MissRatioCurve sampled_curve = computeSampledMissRatioCurve(process_id, rate);
+        std::vector<double> sampled = missRatioFaults(sampled_curve);
+        double references = std::max<double>(memoryAddresses[process_id].size(), 1);
+        double error = 0;
+        for (size_t m = 1; m < exact.size(); ++m) {
+            double estimate = m < sampled.size() ? sampled[m] / std::max(sampled_curve.references, 1.0)
+                                                 : sampled.back() / std::max(sampled_curve.references, 1.0);
+            error += std::fabs(exact[m] / references - estimate);
+        }
+        std::cout << "Miss ratio curve for process " << process_id << ": mean absolute error "
+                  << error / std::max<size_t>(exact.size() - 1, 1) << " at sampling rate " << sampled_curve.sample_rate << std::endl;
+    }
+
+    auto totalFaults = [](size_t policy) {
+        Simulation simulation(0, policy);
+        simulation.simulateAlgorithmPair();
+        long faults = 0;
+        for (const auto& pf : simulation.pageFaults) faults += pf.second;
+        return faults;
+    };
+    std::vector<long> exact_faults;
+    for (size_t policy = 0; policy < pageReplacementNames.size(); policy++) exact_faults.push_back(totalFaults(policy));
+    applySpatialSampling(rate);
+    buildNextUseIndex();
+    computeFrameQuotas();
+    for (size_t policy = 0; policy < pageReplacementNames.size(); policy++) {
+        double estimate = totalFaults(policy) / rate;
+        double error = exact_faults[policy] > 0 ? 100.0 * (estimate - exact_faults[policy]) / exact_faults[policy] : 0.0;
+        std::cout << pageReplacementNames[policy] << ": " << exact_faults[policy] << " faults, sampled estimate "
+                  << std::llround(estimate) << " (" << (error >= 0 ? "+" : "") << error << "%)" << std::endl;
+    }
+}
+
+// Writes the loaded configuration and traces as a binary trace file (see BinaryTraceHeader)
+void writeBinaryTrace(const char* filename) {
+    std::vector<std::pair<std::string, int>> configuration = {
+            {"tp", total_frames}, {"ps", page_size}, {"r", frames_per_process}, {"X", lookahead_window_size},
+            {"min", min_free_pool_size}, {"max", max_free_pool_size}, {"k", total_processes},
+            {"maxtrack", max_disk_track}, {"y", disk_queue_length}, {"seek", seek_time_per_track},
+            {"rot", rotational_latency}, {"xfer", transfer_time}, {"ra", readahead_max},
+            {"tlb", tlb_entries}, {"tlbways", tlb_ways}, {"tlb2", tlb2_entries}, {"tlb2ways", tlb2_ways},
+            {"tlbrepl", tlb_replacement}, {"asid", tlb_asid_tagged}, {"tlbcyc", tlb_hit_cycles},
+            {"tlb2cyc", tlb2_hit_cycles}, {"walk", page_walk_cycles}, {"pt", page_table_kind},
+            {"lfuage", lfu_aging_interval}, {"wsdelta", working_set_window}, {"pff", pff_threshold},
+            {"alloc", allocation_policy}, {"scope", replacement_scope}, {"cpu", cpu_scheduler},
+            {"quantum", cpu_quantum}, {"reftime", reference_time}};
+    for (const auto& priority : processPriority) {
+        configuration.push_back({"prio" + std::to_string(priority.first), priority.second});
+    }
+
+    std::ofstream out(filename, std::ios::binary);
+    if (!out) {
+        std::cerr << "Failed to open binary trace output: " << filename << std::endl;
+        exit(EXIT_FAILURE);
+    }
+
+    BinaryTraceHeader header = {};
+    memcpy(header.magic, BINARY_TRACE_MAGIC, sizeof(header.magic));
+    header.version = BINARY_TRACE_VERSION;
+    header.config_count = configuration.size();
+    header.process_count = total_processes;
+
+    // Lay out every process's track table and addresses after the tables, 8-byte aligned
+    std::vector<BinaryProcessEntry> processes(total_processes);
+    uint64_t offset = sizeof(header) + configuration.size() * sizeof(BinaryConfigEntry) +
+                      processes.size() * sizeof(BinaryProcessEntry);
+    auto align = [](uint64_t value) { return (value + 7) & ~(uint64_t)7; };
+    for (int process_id = 1; process_id <= total_processes; process_id++) {
+        BinaryProcessEntry& entry = processes[process_id - 1];
+        const AddressTrace& trace = memoryAddresses[process_id];
+        entry.process_id = process_id;
+        entry.pages = diskPages[process_id].size();
+        entry.track_offset = offset;
+        offset = align(offset + entry.pages * sizeof(DiskPage));
+        entry.references = trace.size();
+        entry.address_offset = offset;
+        entry.address_bytes = trace.bytes;
+        offset = align(offset + trace.bytes);
+    }
+
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    for (const auto& setting : configuration) {
+        BinaryConfigEntry entry = {};
+        strncpy(entry.key, setting.first.c_str(), sizeof(entry.key) - 1);
+        entry.value = setting.second;
+        out.write(reinterpret_cast<const char*>(&entry), sizeof(entry));
+    }
+    out.write(reinterpret_cast<const char*>(processes.data()), processes.size() * sizeof(BinaryProcessEntry));
+    for (const auto& entry : processes) {
+        out.seekp(entry.track_offset);
+        out.write(reinterpret_cast<const char*>(diskPages[entry.process_id].data()), entry.pages * sizeof(DiskPage));
+        out.seekp(entry.address_offset);
+        out.write(reinterpret_cast<const char*>(memoryAddresses[entry.process_id].data()), entry.address_bytes);
+    }
+    std::cout << "Binary trace written to " << filename << std::endl;
+}
+
+bool isBinaryTrace(const char* filename) {
+    char magic[sizeof(BINARY_TRACE_MAGIC)] = {};
+    std::ifstream file(filename, std::ios::binary);
+    file.read(magic, sizeof(magic));
+    return file && memcmp(magic, BINARY_TRACE_MAGIC, sizeof(magic)) == 0;
+}
+
+// Maps a binary trace file. The mapping stays for the life of the program and the address traces
+// decode straight out of it; only the small page->track tables are copied.
+void loadBinaryTrace(const char* filename) {
+    int fd = open(filename, O_RDONLY);
+    struct stat info;
+    if (fd == -1 || fstat(fd, &info) == -1) {
+        std::cerr << "Failed to open file: " << filename << std::endl;
+        exit(EXIT_FAILURE);
+    }
+    size_t length = info.st_size;
+    void* mapping = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (mapping == MAP_FAILED) {
+        std::cerr << "Failed to map binary trace " << filename << ": " << strerror(errno) << std::endl;
+        exit(EXIT_FAILURE);
+    }
+    const unsigned char* base = static_cast<const unsigned char*>(mapping);
+    madvise(mapping, length, MADV_SEQUENTIAL);
+
+    auto corrupt = [&](const char* reason) {
+        std::cerr << "Invalid binary trace " << filename << ": " << reason << std::endl;
+        exit(EXIT_FAILURE);
+    };
+    if (length < sizeof(BinaryTraceHeader)) corrupt("truncated header");
+    const BinaryTraceHeader* header = reinterpret_cast<const BinaryTraceHeader*>(base);
+    if (header->version != BINARY_TRACE_VERSION) corrupt("unsupported version");
+    uint64_t tables_end = sizeof(BinaryTraceHeader) + (uint64_t)header->config_count * sizeof(BinaryConfigEntry) +
+                          (uint64_t)header->process_count * sizeof(BinaryProcessEntry);
+    if (tables_end > length) corrupt("truncated tables");
+
+    const BinaryConfigEntry* config = reinterpret_cast<const BinaryConfigEntry*>(base + sizeof(BinaryTraceHeader));
+    for (uint32_t i = 0; i < header->config_count; i++) {
+        handleConfiguration(std::string(config[i].key, strnlen(config[i].key, sizeof(config[i].key))), config[i].value);
+    }
+
+    const BinaryProcessEntry* processes = reinterpret_cast<const BinaryProcessEntry*>(config + header->config_count);
+    for (uint32_t i = 0; i < header->process_count; i++) {
+        const BinaryProcessEntry& entry = processes[i];
+        if (entry.track_offset + entry.pages * sizeof(DiskPage) > length ||
+            entry.address_offset + entry.address_bytes > length) {
+            corrupt("process data out of range");
+        }
+        const DiskPage* pages = reinterpret_cast<const DiskPage*>(base + entry.track_offset);
+        diskPages[entry.process_id].assign(pages, pages + entry.pages);
+        pagesPerProcess[entry.process_id] = entry.pages;
+
+        AddressTrace& trace = memoryAddresses[entry.process_id];
+        trace.mapped = base + entry.address_offset;
+        trace.bytes = entry.address_bytes;
+        trace.count = entry.references;
+    }
+}
+
+int main(int argc, char *argv[]) {
+    if (argc > 1 && std::string(argv[1]) == "--generate") return generateTrace(argc, argv);
+    const char* mrc_output = nullptr;
+    const char* binary_output = nullptr;
+    const char* json_output = nullptr;
+    const char* csv_output = nullptr;
+    bool benchmark = false;
+    double sampling = 1.0;
+    bool check_sampling = false;
+    bool usage_error = argc < 2;
+    for (int i = 2; i < argc && !usage_error; i++) {
+        std::string option = argv[i];
+        if (option == "--mrc" && i + 1 < argc) mrc_output = argv[++i];
+        else if (option == "--convert" && i + 1 < argc) binary_output = argv[++i];
+        else if (option == "--realtime") realtime_pacing = true;
+        else if (option == "--benchmark") benchmark = true;
+        else if ((option == "--sample" || option == "--sample-check") && i + 1 < argc) {
+            sampling = std::atof(argv[++i]);
+            check_sampling = option == "--sample-check";
+            usage_error = !(sampling > 0.0 && sampling <= 1.0);
+        }
+        else if (option == "--json" && i + 1 < argc) json_output = argv[++i];
+        else if (option == "--csv" && i + 1 < argc) csv_output = argv[++i];
+        else if (option == "--verbose" && i + 1 < argc) verbosity = std::atoi(argv[++i]);
+        else usage_error = true;
+    }
+    if (usage_error) {
+        std::cerr << "Usage: " << argv[0] << " <configuration file | binary trace> [--convert <output.bin>] [--mrc <output.csv>] [--realtime]"
+                     " [--json <metrics.json>] [--csv <metrics.csv>] [--verbose <0-2>] [--benchmark]"
+                     " [--sample <rate> | --sample-check <rate>]\n"
+                  << "       " << argv[0] << " --generate <pattern> <output.txt> [generator options]\n";
+        return EXIT_FAILURE;
+    }
+
+    if (isBinaryTrace(argv[1])) loadBinaryTrace(argv[1]);
+    else readConfiguration(argv[1]);
+    if (binary_output != nullptr) {
+        writeBinaryTrace(binary_output);
+        return 0;
+    }
+    if (check_sampling) {
+        buildNextUseIndex();
+        computeFrameQuotas();
+        checkSampling(sampling);
+        return 0;
+    }
+    if (mrc_output != nullptr) sample_rate = sampling;  // The curve estimator samples on its own
+    else if (sampling < 1.0) applySpatialSampling(sampling);
+    buildNextUseIndex();
+    computeFrameQuotas();
+
+    if (mrc_output != nullptr) {
+        // One stack-distance pass per process instead of a simulation per frame count
+        exportMissRatioCurves(mrc_output);
+        return 0;
+    }
+    if (benchmark) {
+        runBenchmark();
+        return 0;
+    }
+    // Run simulation for each combination of disk scheduling and page replacement
+    runAllAlgorithmPairs();
+    if (json_output != nullptr) writeMetricsJson(json_output);
+    if (csv_output != nullptr) writeMetricsCsv(csv_output);
 
     return 0;
 }